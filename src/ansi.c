@@ -0,0 +1,116 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ansi.h"
+
+#include <string.h>
+
+enum { STATE_TEXT, STATE_ESCAPE, STATE_SEQUENCE };
+
+enum { PHASE_NUMBER, PHASE_TEXT };
+
+/* the output is tokenized in place in a single pass: escape sequences are
+ * dropped, a leading line number is recognised when an escape sequence sets
+ * it apart from its separator, and every colored span of the text becomes a
+ * highlight */
+static void tokenize(char *output, struct ansi_line_t *line, int phase) {
+    char *read = output;
+    char *write = output;
+    char *text = output;
+    int state = STATE_TEXT;
+    int number = 0;
+    int digits = 0;
+    int escaped = 0;
+    int reset = 1;
+    int highlighted = 0;
+
+    line->line_number = 0;
+    line->separator = '\0';
+    line->nbhighlight = 0;
+
+    for (; *read; read++) {
+        char c = *read;
+
+        switch (state) {
+            case STATE_ESCAPE:
+                state = c == '[' ? STATE_SEQUENCE : STATE_TEXT;
+                reset = 1;
+                continue;
+
+            case STATE_SEQUENCE:
+                /* parameters: an empty or zero SGR resets the colors */
+                if ((c >= '0' && c <= '9') || c == ';') {
+                    if (c != '0') reset = 0;
+                    continue;
+                }
+
+                state = STATE_TEXT;
+                if (c != 'm') continue;
+
+                if (phase == PHASE_NUMBER) {
+                    escaped = digits > 0;
+                } else if (!reset && !highlighted &&
+                           line->nbhighlight < MAX_HIGHLIGHTS) {
+                    line->highlights[line->nbhighlight].begin = write - text;
+                    highlighted = 1;
+                } else if (reset && highlighted) {
+                    line->highlights[line->nbhighlight++].end = write - text;
+                    highlighted = 0;
+                }
+                continue;
+
+            default:
+                if (c == '\033') {
+                    state = STATE_ESCAPE;
+                    continue;
+                }
+                break;
+        }
+
+        if (phase == PHASE_NUMBER) {
+            if (c >= '0' && c <= '9' && !escaped) {
+                number = number * 10 + c - '0';
+                digits++;
+            } else if (escaped && (c == ':' || c == '-' || c == '=')) {
+                line->line_number = number;
+                line->separator = c;
+                phase = PHASE_TEXT;
+                text = write;
+                continue;
+            } else {
+                phase = PHASE_TEXT;
+            }
+        }
+
+        *write++ = c;
+    }
+
+    if (highlighted) line->highlights[line->nbhighlight++].end = write - text;
+
+    *write = '\0';
+    line->text = text;
+    line->length = write - text;
+}
+
+void tokenize_ansi(char *output, struct ansi_line_t *line) {
+    tokenize(output, line, PHASE_NUMBER);
+}
+
+void tokenize_ansi_text(char *output, struct ansi_line_t *line) {
+    tokenize(output, line, PHASE_TEXT);
+}
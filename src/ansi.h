@@ -0,0 +1,39 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANSI_H
+#define ANSI_H
+
+#include "line.h"
+
+/* a line of colored backend output once its escape sequences are removed:
+ * "<number><separator><text>" for result lines, plain text otherwise */
+struct ansi_line_t {
+    int line_number;   /* 0 when the line has no line number */
+    char separator;    /* ':' for matches, '-' or '=' for context */
+    char *text;
+    size_t length;
+    range_t highlights[MAX_HIGHLIGHTS];
+    int nbhighlight;
+};
+
+void tokenize_ansi(char *output, struct ansi_line_t *line);
+/* same without looking for a line number */
+void tokenize_ansi_text(char *output, struct ansi_line_t *line);
+
+#endif
@@ -0,0 +1,212 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "history.h"
+#include "options.h"
+#include "search.h"
+#include "search_utils.h"
+
+/* one out of EXPLORE_INTERVAL searches tries a backend never measured */
+#define EXPLORE_INTERVAL 4
+
+void do_search(struct search_t *search);
+
+static int is_in_path(const char *name) {
+    char path[PATH_MAX];
+    const char *paths = getenv("PATH");
+
+    while (paths && *paths) {
+        size_t length = strcspn(paths, ":");
+        snprintf(path, sizeof(path), "%.*s/%s", (int)length, paths, name);
+        if (access(path, X_OK) == 0) return 1;
+
+        paths += length;
+        if (*paths) paths++;
+    }
+
+    return 0;
+}
+
+static void copy_record(void *data, char *record, size_t length) {
+    char *toplevel = data;
+
+    if (!*toplevel) snprintf(toplevel, PATH_MAX, "%s", record);
+}
+
+static int get_toplevel(const char *directory, char *toplevel) {
+    char *argv[] = {"git", "-C", (char *)directory, "rev-parse",
+                    "--show-toplevel", NULL};
+
+    *toplevel = '\0';
+    return run_command(argv, '\n', NULL, NULL, copy_record, toplevel) == 0 &&
+           *toplevel;
+}
+
+/* hybrid searches need git paths relative to the current directory, that
+ * is both in the same work tree */
+static int is_git_work_tree(const char *directory) {
+    char toplevel[PATH_MAX];
+    char current[PATH_MAX];
+
+    return get_toplevel(directory, toplevel) && get_toplevel(".", current) &&
+           !strcmp(toplevel, current);
+}
+
+/* the tree is probed once per root, not for every search restarted as the
+ * pattern is typed. Searches run one at a time */
+static char probed_root[PATH_MAX];
+static int probed_work_tree;
+
+static int is_probed_work_tree(struct options_t *options, const char *root) {
+    if (strcmp(probed_root, root)) {
+        probed_work_tree =
+                is_in_path("git") && is_git_work_tree(options->directory);
+        snprintf(probed_root, sizeof(probed_root), "%s", root);
+    }
+
+    return probed_work_tree;
+}
+
+static void get_history_path(char *path, size_t size) {
+    char directory[PATH_MAX];
+    const char *cache = getenv("XDG_CACHE_HOME");
+
+    if (cache && *cache)
+        snprintf(directory, sizeof(directory), "%s/ngp", cache);
+    else
+        snprintf(directory, sizeof(directory), "%s/.cache/ngp",
+                 getenv("HOME") ? getenv("HOME") : ".");
+
+    /* the parent of the cache may not exist either */
+    char *slash = strrchr(directory, '/');
+    *slash = '\0';
+    mkdir(directory, 0700);
+    *slash = '/';
+    mkdir(directory, 0700);
+
+    snprintf(path, size, "%s/history", directory);
+}
+
+static const char *get_backend_name(struct options_t *options, int type) {
+    return type == NGP_SEARCH ? "nat" : options->parsers[type].name;
+}
+
+static double get_score(struct sample_t *sample) {
+    return sample->first_result + sample->total;
+}
+
+/* the tree decides first, then measures: once backends have been timed
+ * below root, the one with the best time to first result plus total time
+ * wins, with a search now and then trying a backend never measured. ag is
+ * no candidate, it skips the binary files nat reads and the results would
+ * depend on the backend picked */
+static int choose_backend(struct options_t *options, struct history_t *history,
+                          const char *root) {
+    int candidates[2];
+    int nbcandidate = 0;
+    int guess = NGP_SEARCH;
+    int best = -1, unmeasured = -1, runs = 0;
+    int i;
+
+    candidates[nbcandidate++] = NGP_SEARCH;
+
+    if (is_probed_work_tree(options, root)) {
+        candidates[nbcandidate++] = HYBRID_SEARCH;
+        guess = HYBRID_SEARCH;
+    }
+
+    for (i = 0; i < nbcandidate; i++) {
+        struct sample_t *sample = get_sample(
+                history, root, get_backend_name(options, candidates[i]));
+
+        if (!sample) {
+            if (unmeasured < 0 || candidates[i] == guess)
+                unmeasured = candidates[i];
+            continue;
+        }
+
+        runs += sample->runs;
+        if (best < 0 ||
+            get_score(sample) <
+                    get_score(get_sample(history, root,
+                                         get_backend_name(options, best))))
+            best = candidates[i];
+    }
+
+    if (best < 0 || unmeasured == guess) return guess;
+
+    if (unmeasured >= 0 && runs % EXPLORE_INTERVAL == 0) return unmeasured;
+
+    return best;
+}
+
+static double get_elapsed(struct timespec *from, struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) * 1e3 +
+           (to->tv_nsec - from->tv_nsec) / 1e6;
+}
+
+void do_auto_search(struct search_t *search) {
+    struct options_t *options = search->options;
+    struct history_t *history = malloc(sizeof(*history));
+    struct timespec start, end;
+    char path[PATH_MAX];
+    char root[PATH_MAX];
+
+    if (!realpath(options->directory, root))
+        snprintf(root, sizeof(root), "%s", options->directory);
+
+    get_history_path(path, sizeof(path));
+    read_history(history, path);
+
+    /* options are shared with the next searches, which choose again. The
+     * hybrid mode reads the files nat would */
+    search->type = choose_backend(options, history, root);
+    search->every_file = 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do_search(search);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double total = get_elapsed(&start, &end);
+    double first_result = total;
+
+    pthread_mutex_lock(&search->data_mutex);
+    if (search->result->nbentry > 0)
+        first_result = get_elapsed(&start, &search->result->first_entry);
+    pthread_mutex_unlock(&search->data_mutex);
+
+    /* a search stopped half way says nothing of its backend */
+    if (is_search_stale(search)) {
+        free(history);
+        return;
+    }
+
+    /* the file may have changed since it was read */
+    read_history(history, path);
+    add_sample(history, root, get_backend_name(options, search->type),
+               first_result, total);
+    write_history(history, path);
+
+    free(history);
+}
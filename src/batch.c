@@ -0,0 +1,121 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "batch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "file.h"
+
+struct staged_line_t {
+    int line;
+    range_t match;
+    size_t length;
+    char text[];
+};
+
+struct batch_t *create_batch(const char *file, int sequence) {
+    struct batch_t *batch = calloc(1, sizeof(*batch));
+
+    batch->file = strdup(file);
+    batch->sequence = sequence;
+
+    return batch;
+}
+
+static size_t staged_line_size(size_t length) {
+    size_t size = sizeof(struct staged_line_t) + length + 1;
+    return (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+}
+
+void add_batch_line(struct batch_t *batch, const char *line, size_t length,
+                    int line_number, range_t match) {
+    size_t size = staged_line_size(length);
+
+    if (batch->count_only) {
+        batch->nbline++;
+        return;
+    }
+
+    if (batch->size + size > batch->capacity) {
+        batch->capacity = batch->capacity ? batch->capacity * 2 : 4096;
+        while (batch->size + size > batch->capacity) batch->capacity *= 2;
+        batch->lines = realloc(batch->lines, batch->capacity);
+    }
+
+    struct staged_line_t *staged =
+            (struct staged_line_t *)(batch->lines + batch->size);
+    staged->line = line_number;
+    staged->match = match;
+    staged->length = length;
+    memcpy(staged->text, line, length);
+    staged->text[length] = '\0';
+
+    batch->size += size;
+    batch->nbline++;
+}
+
+void commit_batch(struct result_t *result, struct batch_t *batch) {
+    size_t offset = 0;
+
+    if (batch->nbline == 0) return;
+
+    result->entries = create_file(result, batch->file);
+
+    if (batch->count_only) {
+        struct file_t *file = get_type(result->entries, FILE_ENTRY);
+        file->count = batch->nbline;
+        return;
+    }
+
+    while (offset < batch->size) {
+        struct staged_line_t *staged =
+                (struct staged_line_t *)(batch->lines + offset);
+
+        result->entries = create_line(result, staged->text, staged->line,
+                                      staged->match);
+        offset += staged_line_size(staged->length);
+    }
+}
+
+/* the lines of batch go to lines, as lines of file left out of result,
+ * returns their number */
+int detach_batch(struct result_t *result, struct batch_t *batch, int file,
+                 struct entry_t **lines) {
+    size_t offset = 0;
+    int nbline = 0;
+
+    while (offset < batch->size) {
+        struct staged_line_t *staged =
+                (struct staged_line_t *)(batch->lines + offset);
+
+        lines[nbline++] = create_detached_line(result, staged->text,
+                                               staged->line, staged->match,
+                                               file);
+        offset += staged_line_size(staged->length);
+    }
+
+    return nbline;
+}
+
+void free_batch(struct batch_t *batch) {
+    free(batch->file);
+    free(batch->lines);
+    free(batch);
+}
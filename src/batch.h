@@ -0,0 +1,50 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "line.h"
+#include "result.h"
+
+/* matches of a single file staged outside of the result, so that they can
+ * be built without holding the data mutex and committed in one go */
+struct batch_t {
+    int sequence;
+    char *file;
+
+    char *lines;
+    size_t size;
+    size_t capacity;
+    int nbline;
+
+    /* matches are counted, not staged */
+    int count_only;
+    /* read to the end, even once the search is stale */
+    int whole_file;
+};
+
+struct batch_t *create_batch(const char *file, int sequence);
+void add_batch_line(struct batch_t *batch, const char *line, size_t length,
+                    int line_number, range_t match);
+void commit_batch(struct result_t *result, struct batch_t *batch);
+int detach_batch(struct result_t *result, struct batch_t *batch, int file,
+                 struct entry_t **lines);
+void free_batch(struct batch_t *batch);
+
+#endif
@@ -36,7 +36,7 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
     "editor = \"vim -c 'set hls' -c 'silent /\%1$s' -c \%2$d \%3$s\"\n"        \
     "//editor = \"emacs +\%2$d \%3$s &\"\n"                                    \
     "//editor = \"subl \%3$s:\%2$d 1>/dev/null 2>&1\"\n\n"                     \
-    "// default parser: nat (native), ag or git\n"                             \
+    "// default parser: nat, ag, git, rg, hybrid, auto or one of parsers\n"    \
     "default_parser = \"nat\"\n\n"                                             \
     "/* external parser commands :\n"                                          \
     "*     arg \%1$s = options\n"                                              \
@@ -44,7 +44,33 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
     "*     arg \%3$s = directory\n"                                            \
     "*/\n"                                                                     \
     "ag_cmd = \"ag \%1$s \\\"\%2$s\\\" \%3$s\"\n"                              \
-    "git_cmd = \"git grep \%1$s \\\"\%2$s\\\" \%3$s\"\n\n"                     \
+    "git_cmd = \"git -c color.grep.match=red \"\n"                             \
+    "          \"-c color.grep.selected=normal \"\n"                           \
+    "          \"-c color.grep.context=normal \"\n"                            \
+    "          \"-c color.grep.function=normal \"\n"                           \
+    "          \"grep \%1$s \\\"\%2$s\\\" \%3$s\"\n"                           \
+    "rg_cmd = \"rg \%1$s \\\"\%2$s\\\" \%3$s\"\n\n"                            \
+    "/* other parsers, selected with --parser=<name>, output one of the\n"     \
+    "   formats: ackmate, null, json, grep (file:line:text) or vimgrep\n"      \
+    "   (file:line:column:text)\n"                                             \
+    "parsers = (\n"                                                            \
+    "    { name = \"plaingit\";\n"                                             \
+    "      command = \"git grep \%1$s \\\"\%2$s\\\" \%3$s\";\n"                \
+    "      format = \"vimgrep\";\n"                                            \
+    "      arguments = \"-n --column --no-color\"; }\n"                        \
+    ");\n"                                                                     \
+    "*/\n\n"                                                                   \
+    "/* lines longer than max_line_length characters only keep\n"              \
+    "   line_window characters around their match */\n"                        \
+    "max_line_length = 1024\n"                                                 \
+    "line_window = 256\n\n"                                                    \
+    "/* memory in megabytes results may use before being spilled\n"            \
+    "   to a temporary file, 0 means no limit */\n"                            \
+    "result_memory_budget = 1024\n\n"                                          \
+    "// threads used by the native parser, 0 means one per cpu\n"              \
+    "threads = 0\n\n"                                                          \
+    "// screen updates per second at most while results stream in\n"           \
+    "frame_rate = 30\n\n"                                                      \
     "/* themes\n"                                                              \
     "   colors available: cyan, yellow, red, green,\n"                         \
     "   black, white, blue, magenta */\n\n"                                    \
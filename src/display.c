@@ -20,11 +20,17 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <ncurses.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "batch.h"
 #include "entry.h"
+#include "file.h"
+#include "line.h"
+#include "ngp_search.h"
 #include "search.h"
 #include "theme.h"
 #include "utils.h"
+#include "view.h"
 
 struct display_t *create_display() {
     struct display_t *display;
@@ -33,6 +39,7 @@ struct display_t *create_display() {
     display->cursor = 1;
     display->index = 0;
     display->ncurses_initialized = 0;
+    display->drawn_index = -1;
 
     return display;
 }
@@ -43,10 +50,12 @@ void start_ncurses(struct display_t *display, struct configuration_t *config) {
     noecho();
     keypad(stdscr, TRUE);
     nodelay(stdscr, TRUE);
+    set_escdelay(25);
     start_color();
     use_default_colors();
     init_pair(1, -1, -1);
     curs_set(0);
+    invalidate_display(display);
 
     struct theme_t *theme;
     theme = read_theme(config);
@@ -56,48 +65,283 @@ void start_ncurses(struct display_t *display, struct configuration_t *config) {
 
 void stop_ncurses(struct display_t *display) { endwin(); }
 
+/* the entries shown are the ones of the filter view if any, of the whole
+ * result otherwise */
+int get_display_count(struct display_t *display, struct search_t *search) {
+    if (display->view) return display->view->nbentry;
+
+    return search->result->nbentry;
+}
+
+struct entry_t *get_display_entry(struct display_t *display,
+                                  struct search_t *search, int index) {
+    if (display->view) return get_view_entry(display->view, index);
+
+    return get_entry(search->result, index);
+}
+
+static int next_shown(struct display_t *display, struct search_t *search,
+                      int index) {
+    if (display->view) return next_view_selectable(display->view, index);
+
+    return next_selectable(search->result, index);
+}
+
+static int previous_shown(struct display_t *display, struct search_t *search,
+                          int index) {
+    if (display->view) return previous_view_selectable(display->view, index);
+
+    return previous_selectable(search->result, index);
+}
+
+static int next_file_shown(struct display_t *display, struct search_t *search,
+                           int index) {
+    if (display->view) return next_view_file(display->view, index);
+
+    return next_file(search->result, index);
+}
+
+static int previous_file_shown(struct display_t *display,
+                               struct search_t *search, int index) {
+    if (display->view) return previous_view_file(display->view, index);
+
+    return previous_file(search->result, index);
+}
+
+/* the filter prompt takes the last row */
+static int get_bottom(struct display_t *display) {
+    return display->prompt || display->view ? LINES - 1 : LINES;
+}
+
+/* the preview takes the lower half */
+int get_page_size(struct display_t *display) {
+    int lines = get_bottom(display);
+
+    if (display->previewing) lines -= lines / 2;
+
+    return lines;
+}
+
+/* shows the entries matching filter only, all of them when it is empty,
+ * or the files whose path contains it when grouped */
+void set_display_filter(struct display_t *display, struct search_t *search,
+                        const char *filter) {
+    struct view_t *view = NULL;
+
+    if (display->grouped)
+        view = create_group_view(search->result, filter, display->view);
+    else if (*filter)
+        view = create_view(search->result, filter, display->view,
+                           get_thread_count(search->options));
+
+    free_view(display->view);
+    display->view = view;
+
+    display->index = 0;
+    display->cursor = next_shown(display, search, 0);
+    if (display->cursor < 0) display->cursor = 0;
+    invalidate_display(display);
+}
+
+void display_prompt(struct display_t *display, struct search_t *search) {
+    curs_set(display->prompt != PROMPT_NONE);
+    if (!display->prompt && !display->view) return;
+
+    attron(COLOR_PAIR(COLOR_LINE));
+    move(LINES - 1, 0);
+    clrtoeol();
+
+    if (display->prompt == PROMPT_PATTERN) {
+        mvprintw(LINES - 1, 0, "search: %s", display->pattern);
+        return;
+    }
+
+    mvprintw(LINES - 1, 0, "/%s", display->filter);
+
+    if (display->view && display->view->grouped && !display->prompt &&
+        !*display->filter) {
+        attron(COLOR_PAIR(COLOR_LINE_NUMBER));
+        mvprintw(LINES - 1, 0, "%d files", display->view->nbfile);
+        attron(COLOR_PAIR(COLOR_LINE));
+    } else if (display->view && display->view->grouped) {
+        attron(COLOR_PAIR(COLOR_LINE_NUMBER));
+        printw("  %d/%d files", display->view->nbfile, search->result->nbfile);
+        attron(COLOR_PAIR(COLOR_LINE));
+    } else if (display->view) {
+        attron(COLOR_PAIR(COLOR_LINE_NUMBER));
+        printw("  %d/%d", display->view->nbselectable,
+               search->result->nbselectable);
+        attron(COLOR_PAIR(COLOR_LINE));
+    }
+
+    if (display->prompt == PROMPT_FILTER)
+        move(LINES - 1, strlen(display->filter) + 1);
+}
+
+static void display_row(struct display_t *display, struct search_t *search,
+                        struct entry_t *entry, int y) {
+    struct group_t *group;
+    int file;
+
+    if (display->view && entry->type == FILE_ENTRY &&
+        (group = get_view_group(display->view, display->index + y, &file))) {
+        display_file_group(entry, search, y, display->cursor == y,
+                           group->expanded);
+        return;
+    }
+
+    display_entry(entry, search, y, display->cursor == y);
+}
+
+static void display_text(const char *text, size_t length, int width) {
+    char line[PATH_MAX];
+    size_t i;
+
+    if (width <= 0) return;
+    if (length > (size_t)width) length = width;
+    if (length >= sizeof(line)) length = sizeof(line) - 1;
+
+    /* tabs or control characters would move the cursor */
+    for (i = 0; i < length; i++)
+        line[i] = (unsigned char)text[i] < ' ' || text[i] == 127 ? ' '
+                                                                 : text[i];
+    line[length] = '\0';
+
+    printw("%s", line);
+}
+
+/* the lines of the file under the cursor around its line, from row top */
+static void display_preview(struct display_t *display,
+                            struct search_t *search, int top) {
+    struct entry_t *entry = get_display_entry(
+            display, search, display->index + display->cursor);
+    struct line_t *line = get_type(entry, LINE_ENTRY);
+    struct file_t *file = get_type(entry, FILE_ENTRY);
+    struct mapped_file_t *mapped = NULL;
+    char path[PATH_MAX] = "";
+    int bottom = get_bottom(display);
+    int number = 1;
+    int y;
+
+    if (line && line->line) {
+        file = get_file(search->result, line->file);
+        number = line->line;
+    }
+
+    if (file) {
+        get_file_path(search->result, file, path, sizeof(path));
+        mapped = get_mapped_file(display->preview, path);
+    }
+
+    /* centered on the line, from the first one for a file */
+    int first = number - (bottom - top - 1) / 2;
+    if (!line || first < 1) first = 1;
+
+    attron(A_REVERSE);
+    attron(COLOR_PAIR(COLOR_FILE));
+    move(top, 0);
+    clrtoeol();
+    mvprintw(top, 0, "%-*.*s", COLS, COLS, path);
+    attroff(A_REVERSE);
+
+    for (y = top + 1; y < bottom; y++, first++) {
+        size_t length;
+        const char *text = mapped ? get_mapped_line(mapped, first, &length)
+                                  : NULL;
+
+        move(y, 0);
+        clrtoeol();
+        if (!text) continue;
+
+        attron(COLOR_PAIR(COLOR_LINE_NUMBER));
+        mvprintw(y, 0, "%d:", first);
+        attron(COLOR_PAIR(COLOR_LINE));
+
+        if (line && first == number) attron(A_REVERSE);
+        display_text(text, length, COLS - getcurx(stdscr));
+        attroff(A_REVERSE);
+    }
+
+    display->drawn_preview = entry;
+}
+
+/* the next display_results() redraws every row */
+void invalidate_display(struct display_t *display) {
+    display->drawn_index = -1;
+}
+
+/* a new page is drawn entirely, otherwise the rows of the cursor before and
+ * after it moved and the entries that became visible are drawn only */
 void display_results(struct display_t *display, struct search_t *search,
                      int terminal_line_nb) {
     int i = 0;
-    struct entry_t *ptr = search->result->start;
 
-    for (i = 0; i < display->index; i++) ptr = ptr->next;
+    /* results keep coming while the view is shown */
+    if (display->view) update_view(display->view, search->result);
+
+    struct entry_t *ptr = get_display_entry(display, search, display->index);
+    int nbrow = get_display_count(display, search) - display->index;
+    int full = display->index != display->drawn_index ||
+               terminal_line_nb != display->drawn_lines;
+
+    if (nbrow > terminal_line_nb) nbrow = terminal_line_nb;
+    if (nbrow < 0) nbrow = 0;
 
-    for (i = 0; i < terminal_line_nb; i++) {
-        if (ptr && display->index + i < search->result->nbentry) {
-            display_entry(ptr, search, i, display->cursor == i);
+    /* a full page where the cursor did not move needs nothing, however
+     * fast results keep coming */
+    if (!full && display->drawn_rows == nbrow &&
+        display->drawn_cursor == display->cursor)
+        return;
 
-            if (ptr->next) ptr = ptr->next;
-        }
+    for (i = 0; i < nbrow && ptr; i++) {
+        if (full || i >= display->drawn_rows || i == display->cursor ||
+            i == display->drawn_cursor)
+            display_row(display, search, ptr, i);
+
+        if (display->view)
+            ptr = get_view_entry(display->view, display->index + i + 1);
+        else
+            ptr = ptr->next;
+    }
+
+    /* rows left by a longer page */
+    if (full && nbrow < terminal_line_nb) {
+        move(nbrow, 0);
+        clrtobot();
     }
+
+    if (display->previewing &&
+        (full || display->drawn_preview !=
+                         get_display_entry(display, search,
+                                           display->index + display->cursor)))
+        display_preview(display, search, terminal_line_nb);
+
+    display->drawn_index = display->index;
+    display->drawn_cursor = display->cursor;
+    display->drawn_rows = nbrow;
+    display->drawn_lines = terminal_line_nb;
 }
 
 static int search_next_upwards(struct display_t *display,
                                struct search_t *search, int ignore_current) {
-    int next_selectable = display->index + display->cursor;
+    int position = display->index + display->cursor;
 
-    if (ignore_current) next_selectable -= 1;
+    if (ignore_current) position -= 1;
 
-    for (; next_selectable > 0; next_selectable--) {
-        if (is_selectable(search, next_selectable)) {
-            return next_selectable - display->index;
-        }
-    }
+    position = previous_shown(display, search, position);
+    if (position > 0) return position - display->index;
 
     return display->cursor;
 }
 
 static int search_next_downwards(struct display_t *display,
                                  struct search_t *search, int ignore_current) {
-    int next_selectable = display->index + display->cursor;
+    int position = display->index + display->cursor;
 
-    if (ignore_current) next_selectable += 1;
+    if (ignore_current) position += 1;
 
-    for (; next_selectable < search->result->nbentry; next_selectable++) {
-        if (is_selectable(search, next_selectable)) {
-            return next_selectable - display->index;
-        }
-    }
+    position = next_shown(display, search, position);
+    if (position >= 0) return position - display->index;
 
     return display->cursor;
 }
@@ -120,16 +364,16 @@ void move_page_up(struct display_t *display, struct search_t *search,
 
 void move_page_down(struct display_t *display, struct search_t *search,
                     int terminal_line_nb) {
+    int nbentry = get_display_count(display, search);
     int max_index;
 
-    if (search->result->nbentry % terminal_line_nb == 0)
-        max_index = (search->result->nbentry - terminal_line_nb);
+    if (nbentry % terminal_line_nb == 0)
+        max_index = (nbentry - terminal_line_nb);
     else
-        max_index = (search->result->nbentry -
-                     (search->result->nbentry % terminal_line_nb));
+        max_index = (nbentry - (nbentry % terminal_line_nb));
 
     if (display->index == max_index)
-        display->cursor = (search->result->nbentry - 1) % terminal_line_nb;
+        display->cursor = (nbentry - 1) % terminal_line_nb;
     else
         display->cursor = 0;
 
@@ -144,18 +388,14 @@ void move_page_down(struct display_t *display, struct search_t *search,
 
 void move_page_up_and_refresh(struct display_t *display,
                               struct search_t *search) {
-    int terminal_line_nb = LINES;
-    clear();
-    refresh();
+    int terminal_line_nb = get_page_size(display);
     move_page_up(display, search, terminal_line_nb);
     display_results(display, search, terminal_line_nb);
 }
 
 void move_page_down_and_refresh(struct display_t *display,
                                 struct search_t *search) {
-    int terminal_line_nb = LINES;
-    clear();
-    refresh();
+    int terminal_line_nb = get_page_size(display);
     move_page_down(display, search, terminal_line_nb);
     display_results(display, search, terminal_line_nb);
 }
@@ -164,46 +404,138 @@ void move_cursor_up(struct display_t *display, struct search_t *search,
                     int terminal_line_nb) {
     display->cursor = search_next_upwards(display, search, 1);
 
-    if (display->cursor <= 0) {
-        move_page_up(display, search, terminal_line_nb);
-        clear();
-        refresh();
-    }
+    if (display->cursor <= 0) move_page_up(display, search, terminal_line_nb);
 }
 
 void move_cursor_down(struct display_t *display, struct search_t *search,
                       int terminal_line_nb) {
     display->cursor = search_next_downwards(display, search, 1);
 
-    if (display->cursor > (terminal_line_nb - 1)) {
+    if (display->cursor > (terminal_line_nb - 1))
         move_page_down(display, search, terminal_line_nb);
-        clear();
-        refresh();
-    }
 }
 
 void move_cursor_up_and_refresh(struct display_t *display,
                                 struct search_t *search) {
-    int terminal_line_nb = LINES;
+    int terminal_line_nb = get_page_size(display);
     move_cursor_up(display, search, terminal_line_nb);
     display_results(display, search, terminal_line_nb);
 }
 
 void move_cursor_down_and_refresh(struct display_t *display,
                                   struct search_t *search) {
-    int terminal_line_nb = LINES;
+    int terminal_line_nb = get_page_size(display);
     move_cursor_down(display, search, terminal_line_nb);
     display_results(display, search, terminal_line_nb);
 }
 
+/* the cursor goes to position, on the page holding it if it is not shown */
+static void show_position(struct display_t *display, int position,
+                          int terminal_line_nb) {
+    if (position < display->index ||
+        position >= display->index + terminal_line_nb)
+        display->index = position - position % terminal_line_nb;
+
+    display->cursor = position - display->index;
+}
+
+/* first line of the file after the one of the cursor */
+void move_next_file(struct display_t *display, struct search_t *search,
+                    int terminal_line_nb) {
+    int position = display->index + display->cursor;
+
+    position = next_file_shown(display, search, position);
+    if (position >= 0) position = next_shown(display, search, position);
+    if (position >= 0) show_position(display, position, terminal_line_nb);
+}
+
+/* first line of the file before the one of the cursor */
+void move_previous_file(struct display_t *display, struct search_t *search,
+                        int terminal_line_nb) {
+    int position = display->index + display->cursor;
+
+    position = previous_file_shown(display, search, position);
+    if (position >= 0)
+        position = previous_file_shown(display, search, position);
+    if (position >= 0) position = next_shown(display, search, position);
+    if (position >= 0) show_position(display, position, terminal_line_nb);
+}
+
+void move_next_file_and_refresh(struct display_t *display,
+                                struct search_t *search) {
+    int terminal_line_nb = get_page_size(display);
+    move_next_file(display, search, terminal_line_nb);
+    display_results(display, search, terminal_line_nb);
+}
+
+void move_previous_file_and_refresh(struct display_t *display,
+                                    struct search_t *search) {
+    int terminal_line_nb = get_page_size(display);
+    move_previous_file(display, search, terminal_line_nb);
+    display_results(display, search, terminal_line_nb);
+}
+
+static void scan_group(struct search_t *search, struct group_t *group,
+                       int file) {
+    char path[PATH_MAX];
+    struct batch_t *batch;
+
+    get_file_path(search->result, get_file(search->result, file), path,
+                  sizeof(path));
+    batch = scan_file(search, path);
+
+    group->lines = malloc((batch->nbline + 1) * sizeof(*group->lines));
+    group->nbline = detach_batch(search->result, batch, file, group->lines);
+    free_batch(batch);
+}
+
+/* expands or folds the file under the cursor of the grouped view, the lines
+ * of a file whose matches were only counted are read the first time */
+int toggle_display_group(struct display_t *display, struct search_t *search) {
+    int position = display->index + display->cursor;
+    struct entry_t *entry = get_display_entry(display, search, position);
+    struct group_t *group;
+    int file;
+
+    if (!display->view || !entry || entry->type != FILE_ENTRY) return 0;
+
+    group = get_view_group(display->view, position, &file);
+    if (!group) return 0;
+
+    if (!group->expanded && !group->lines &&
+        !has_file_lines(search->result, file))
+        scan_group(search, group, file);
+
+    position = toggle_view_group(display->view, search->result, file);
+    show_position(display, position, get_page_size(display));
+    invalidate_display(display);
+
+    return 1;
+}
+
+void toggle_display_preview(struct display_t *display) {
+    display->previewing = !display->previewing;
+    if (!display->preview) display->preview = create_preview();
+
+    /* the cursor stays on a smaller page */
+    show_position(display, display->index + display->cursor,
+                  get_page_size(display));
+    invalidate_display(display);
+}
+
 void resize_display(struct display_t *display, struct search_t *search,
                     int terminal_line_nb) {
     /* right now this is a bit trivial,
      * but we may do more complex moving around
      * when the window is resized */
     clear();
+    invalidate_display(display);
     display_results(display, search, terminal_line_nb);
     refresh();
 }
 
-void free_display(struct display_t *display) { free(display); }
+void free_display(struct display_t *display) {
+    free_view(display->view);
+    free_preview(display->preview);
+    free(display);
+}
@@ -20,17 +20,54 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #define DISPLAY_H
 
 #include "configuration.h"
+#include "entry.h"
+#include "preview.h"
 #include "search.h"
+#include "view.h"
+
+enum { PROMPT_NONE, PROMPT_FILTER, PROMPT_PATTERN };
 
 struct display_t {
     int index;
     int cursor;
     int ncurses_initialized;
+
+    /* the filter typed after '/', shown through view once not empty, and
+     * the pattern typed after 's' */
+    int prompt;
+    char filter[FILTER_MAX];
+    struct view_t *view;
+    char pattern[LINE_MAX];
+
+    /* one row per file, toggled with 'g' */
+    int grouped;
+
+    /* the lines around the one under the cursor shown below the results,
+     * toggled with 'v' */
+    int previewing;
+    struct preview_t *preview;
+
+    /* what the screen shows, to redraw the rows that changed only */
+    int drawn_index;
+    int drawn_cursor;
+    int drawn_rows;
+    int drawn_lines;
+    struct entry_t *drawn_preview;
 };
 
 struct display_t *create_display();
 void start_ncurses(struct display_t *display, struct configuration_t *config);
 void stop_ncurses(struct display_t *display);
+int get_display_count(struct display_t *display, struct search_t *search);
+struct entry_t *get_display_entry(struct display_t *display,
+                                  struct search_t *search, int index);
+int get_page_size(struct display_t *display);
+void set_display_filter(struct display_t *display, struct search_t *search,
+                        const char *filter);
+int toggle_display_group(struct display_t *display, struct search_t *search);
+void toggle_display_preview(struct display_t *display);
+void display_prompt(struct display_t *display, struct search_t *search);
+void invalidate_display(struct display_t *display);
 void display_results(struct display_t *display, struct search_t *search,
                      int terminal_line_nb);
 void resize_display(struct display_t *display, struct search_t *search,
@@ -43,6 +80,10 @@ void move_page_up_and_refresh(struct display_t *display,
                               struct search_t *search);
 void move_page_down_and_refresh(struct display_t *display,
                                 struct search_t *search);
+void move_next_file_and_refresh(struct display_t *display,
+                                struct search_t *search);
+void move_previous_file_and_refresh(struct display_t *display,
+                                    struct search_t *search);
 void move_cursor_up(struct display_t *display, struct search_t *search,
                     int terminal_line_nb);
 void move_cursor_down(struct display_t *display, struct search_t *search,
@@ -51,6 +92,10 @@ void move_page_up(struct display_t *display, struct search_t *search,
                   int terminal_line_nb);
 void move_page_down(struct display_t *display, struct search_t *search,
                     int terminal_line_nb);
+void move_next_file(struct display_t *display, struct search_t *search,
+                    int terminal_line_nb);
+void move_previous_file(struct display_t *display, struct search_t *search,
+                        int terminal_line_nb);
 void free_display(struct display_t *display);
 
 #endif
@@ -28,15 +28,27 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 
 void display_entry(struct entry_t *entry, struct search_t *search, int y,
                    int is_cursor_on_entry) {
-    entry->vtable->display(entry, search, y, is_cursor_on_entry);
+    switch (entry->type) {
+        case FILE_ENTRY:
+            display_file(entry, search, y, is_cursor_on_entry);
+            break;
+        case LINE_ENTRY:
+            display_line(entry, search, y, is_cursor_on_entry);
+            break;
+    }
 }
 
-void free_entry(struct entry_t *entry) { entry->vtable->free(entry); }
-
-int is_entry_selectable(struct entry_t *entry) {
-    return entry->vtable->is_selectable(entry);
-}
+int is_entry_selectable(struct entry_t *entry) { return entry->is_selectable; }
 
 void *get_type(struct entry_t *entry, entry_type_t type) {
-    return entry->vtable->get_type(entry, type);
+    if (!entry || entry->type != type) return NULL;
+
+    switch (type) {
+        case FILE_ENTRY:
+            return container_of(entry, struct file_t, entry);
+        case LINE_ENTRY:
+            return container_of(entry, struct line_t, entry);
+    }
+
+    return NULL;
 }
@@ -20,6 +20,7 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #define ENTRY_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "search.h"
 
@@ -28,24 +29,19 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 
 typedef enum { FILE_ENTRY, LINE_ENTRY } entry_type_t;
 
+/* entries are tagged with their type and flags are packed, keeping
+ * the header small enough for result scans to stay cache-friendly */
 struct entry_t {
-    struct entry_vtable *vtable;
     struct entry_t *next;
+    uint8_t type;
+    uint8_t is_selectable : 1;
+    uint8_t opened : 1;
     char data[];
 };
 
-struct entry_vtable {
-    void (*display)(struct entry_t *, struct search_t *, int, int);
-    int (*is_selectable)(struct entry_t *);
-    void (*free)(struct entry_t *);
-    void *(*get_type)(struct entry_t *, entry_type_t);
-};
-
 void display_entry(struct entry_t *entry, struct search_t *search, int y,
                    int is_cursor_on_entry);
 
-void free_entry(struct entry_t *entry);
-
 int is_entry_selectable(struct entry_t *entry);
 
 void *get_type(struct entry_t *entry, entry_type_t type);
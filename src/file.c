@@ -18,66 +18,41 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "file.h"
 
+#include "path.h"
 #include "theme.h"
 #include "utils.h"
 
-static void *get_file(struct entry_t *entry, entry_type_t type);
-
-struct entry_vtable file_vtable = {display_file, is_file_selectable, free_file,
-                                   get_file};
-
-static char *remove_double(char *initial, char c, char *final) {
-    int i, j;
-    int len = strlen(initial);
-
-    for (i = 0, j = 0; i < len; j++) {
-        if (initial[i] != c) {
-            final[j] = initial[i];
-            i++;
-        } else {
-            final[j] = initial[i];
-            if (initial[i + 1] == c)
-                i = i + 2;
-            else
-                i++;
-        }
-    }
-    final[j] = '\0';
-
-    return final;
-}
-
-static void format_path(char *src, char *dest) {
-    if (strncmp(src, "./", 2) == 0)
-        remove_double(src + 2, '/', dest);
-    else
-        remove_double(src, '/', dest);
-}
-
 struct entry_t *create_file(struct result_t *result, char *file) {
-    int len = strlen(file) + 1;
+    const char *basename;
+    int directory = intern_path(result->paths, file, &basename);
+    int len = strlen(basename) + 1;
     struct file_t *new;
 
-    new = calloc(1, sizeof(struct file_t) + len);
-
-    format_path(file, new->entry.data);
-    new->entry.vtable = &file_vtable;
-    result->nbentry++;
+    new = alloc_entry(result, sizeof(struct file_t) + len);
 
-    if (result->entries) {
-        result->entries->next = &new->entry;
-    } else {
-        result->start = &new->entry;
-    }
+    strncpy(new->entry.data, basename, len);
+    new->directory = directory;
+    new->count = 0;
+    new->entry.type = FILE_ENTRY;
+    add_entry(result, &new->entry);
 
     return &new->entry;
 }
 
+char *get_file_path(struct result_t *result, struct file_t *file,
+                    char *buffer, size_t size) {
+    return build_path(result->paths, file->directory, file->entry.data, buffer,
+                      size);
+}
+
 void display_file(struct entry_t *entry, struct search_t *search, int y,
                   int is_cursor_on_entry) {
-    int crop = COLS;
+    struct file_t *file = container_of(entry, struct file_t, entry);
+    int crop = COLS < PATH_MAX ? COLS : PATH_MAX - 1;
     char cropped_line[PATH_MAX] = "";
-    strncpy(cropped_line, entry->data, crop);
+
+    get_file_path(search->result, file, cropped_line, sizeof(cropped_line));
+    cropped_line[crop] = '\0';
 
     /* first clear line */
     move(y, 0);
@@ -91,15 +66,28 @@ void display_file(struct entry_t *entry, struct search_t *search, int y,
     attroff(A_BOLD);
 }
 
-int is_file_selectable(struct entry_t *entry) { return false; }
+/* one row per file in the grouped view, with its number of matches */
+void display_file_group(struct entry_t *entry, struct search_t *search, int y,
+                        int is_cursor_on_entry, int expanded) {
+    struct file_t *file = container_of(entry, struct file_t, entry);
+    int crop = COLS - 2 < PATH_MAX ? COLS - 2 : PATH_MAX - 1;
+    char cropped_line[PATH_MAX] = "";
+
+    get_file_path(search->result, file, cropped_line, sizeof(cropped_line));
+    cropped_line[crop > 0 ? crop : 0] = '\0';
 
-void free_file(struct entry_t *entry) {
-    struct file_t *ptr = container_of(entry, struct file_t, entry);
-    free(ptr);
-}
+    if (is_cursor_on_entry) attron(A_REVERSE);
+
+    move(y, 0);
+    clrtoeol();
+
+    attron(A_BOLD);
+    attron(COLOR_PAIR(COLOR_FILE));
+    mvprintw(y, 0, "%c %s", expanded ? '-' : '+', cropped_line);
+    attroff(A_BOLD);
 
-static void *get_file(struct entry_t *entry, entry_type_t type) {
-    if (type == FILE_ENTRY) return container_of(entry, struct file_t, entry);
+    attron(COLOR_PAIR(COLOR_LINE_NUMBER));
+    printw("  %d", file->count);
 
-    return NULL;
+    if (is_cursor_on_entry) attroff(A_REVERSE);
 }
@@ -21,14 +21,20 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "entry.h"
 
+/* entry data only holds the basename, the directory is interned in the
+ * path table of the result */
 struct file_t {
+    int32_t directory;
+    int32_t count; /* number of matching lines */
     struct entry_t entry;
 };
 
 struct entry_t *create_file(struct result_t *result, char *file);
+char *get_file_path(struct result_t *result, struct file_t *file,
+                    char *buffer, size_t size);
 void display_file(struct entry_t *entry, struct search_t *search, int y,
                   int is_cursor_on_entry);
-void free_file(struct entry_t *entry);
-int is_file_selectable(struct entry_t *entry);
+void display_file_group(struct entry_t *entry, struct search_t *search, int y,
+                        int is_cursor_on_entry, int expanded);
 
 #endif
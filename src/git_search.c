@@ -15,117 +15,91 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 */
+
+#include "parser.h"
+
+#include <stdlib.h>
 #include <string.h>
 
+#include "ansi.h"
 #include "file.h"
 #include "line.h"
 #include "search_utils.h"
 
 /*
- * command: git grep -n --heading -C 1 -p --color=always "git_"
+ * command: git grep -z -n --column -C 1 --color=always "git_"
+ *
+ *src/search/search.c\0 28\0 void do_ag_search(struct search_t *search);
+ *src/search/search.c\0 29\0 10\0 void do_[1;31mgit_[msearch(struct search_t *search);
+ *src/search/search.c\0 30\0
+ *[36m--[m
+ *src/search/search.c\0 56\0         case GIT_SEARCH:
+ *src/search/search.c\0 57\0 23\0             return do_[1;31mgit_[msearch(search);
  *
- *[36m--[m
- *src/search/search.c
- *28[36m=[mvoid do_ag_search(struct search_t *search);
- *29[36m:[mvoid do_[1;31mgit_[msearch(struct search_t *search);
- *30[36m-[m
- *[36m--[m
- *47[36m=[mvoid do_search(struct search_t *search)
- *[36m--[m
- *56[36m-[m        case GIT_SEARCH:
- *57[36m:[m            return do_[1;31mgit_[msearch(search);
- *58[36m-[m
+ * fields are NUL separated, matches carry a column field that context
+ * lines lack. Colors only serve to delimit the highlights and are stripped
+ * from every field: the git command only colors the matches, whatever the
+ * theme of the user.
  */
 
-static int match_blank_line(struct result_t *result, const char *output) {
-    /* empty line */
-    size_t line_length = strlen(output);
-    if (line_length == 0) {
-        result->entries = create_blank_line(result);
-        return 1;
-    }
-
-    /* only colored '--' */
-    const char *match = apply_regex(output, "^(\\033\\[36m)(--)(\\033\\[m)$");
-    if (!match) return 0;
-
-    result->entries = create_blank_line(result);
-    pcre_free_substring(match);
+#define MAX_FIELDS 4
 
-    return 1;
-}
-
-static int match_file(struct result_t *result, const char *output) {
-    const char *match = apply_regex(output, "^([^\\033]+)$");
-    if (!match) return 0;
+static int split_record(char *output, size_t length, char **fields) {
+    char *end = output + length;
+    int nbfield = 0;
 
-    if (!validate_file(match)) return 1;
+    while (nbfield < MAX_FIELDS - 1) {
+        char *separator = memchr(output, '\0', end - output);
+        if (!separator) break;
 
-    result->entries = create_file(result, (char *)match);
-    pcre_free_substring(match);
+        fields[nbfield++] = output;
+        output = separator + 1;
+    }
+    fields[nbfield++] = output;
 
-    return 1;
+    return nbfield;
 }
 
-static int match_line(struct result_t *result, const char *output) {
-    /* match line number */
-    const char *match = apply_regex(output, "^\\d+");
-    if (!match) return 0;
+void parse_null_line(struct result_t *result, char *output, size_t length) {
+    struct ansi_line_t field;
+    char *fields[MAX_FIELDS];
+    int nbfield = split_record(output, length, fields);
 
-    size_t line_number = atoi(match);
-    pcre_free_substring(match);
-
-    if (line_number == 0) return 0;
-
-    /* match context lines ('-' or '=' after line number) */
-    match = apply_regex(output, "(?<=([-=]\\033\\[m)).*$");
-    if (match) {
-        result->entries =
-                create_unselectable_line(result, (char *)match, line_number);
-        pcre_free_substring(match);
-        return 1;
+    if (nbfield == 1) {
+        tokenize_ansi_text(output, &field);
+        if (strcmp(field.text, "--") == 0)
+            result->entries = create_blank_line(result);
+        return;
     }
 
-    range_t highlight = {0, 0};
-    size_t line_length = 1024;
-    char *line = calloc(line_length, sizeof(*line));
+    if (nbfield < 3) return;
 
-    /* match from line number until match */
-    match = apply_regex(output, "(?<=([:]\\033\\[m))[^\\033]*");
-    if (!match) return 0;
-
-    resize_string(&line, &line_length, strlen(match));
-    strcat(line, match);
-    pcre_free_substring(match);
-
-    /* match the highlighted match */
-    match = apply_regex(output, "(?<=(\\033\\[1;31m))[^\\033]*");
-    if (!match) return 0;
-
-    highlight.begin = strlen(line);
-    highlight.end = highlight.begin + strlen(match);
-
-    resize_string(&line, &line_length, strlen(match));
-    strcat(line, match);
-    pcre_free_substring(match);
-
-    /* match rest of line */
-    match = apply_regex(output, "(?<=(\\033\\[m))[^\\033]*$");
-    if (!match) return 0;
-
-    resize_string(&line, &line_length, strlen(match));
-    strcat(line, match);
-    pcre_free_substring(match);
+    tokenize_ansi_text(fields[0], &field);
+    if (!is_current_file(result, field.text)) {
+        result->entries = create_file(result, field.text);
+    }
 
-    result->entries = create_line(result, line, line_number, highlight);
+    tokenize_ansi_text(fields[1], &field);
+    int line_number = atoi(field.text);
+    if (line_number <= 0) return;
 
-    return 1;
-}
+    tokenize_ansi_text(fields[nbfield - 1], &field);
+    if (nbfield == 3) {
+        result->entries =
+                create_unselectable_line(result, field.text, line_number);
+        return;
+    }
 
-void do_git_search(struct search_t *search) {
-    char default_arguments[] = "-n --heading --color=always ";
-    external_parser_t git_grep = {default_arguments, match_file, match_line,
-                                  match_blank_line};
+    /* without colors, fall back on the column of the first match */
+    if (field.nbhighlight == 0) {
+        struct ansi_line_t column;
+        tokenize_ansi_text(fields[2], &column);
+        field.highlights[0] =
+                get_column_match(result, field.text, atoi(column.text));
+        field.nbhighlight = field.highlights[0].end > 0;
+    }
 
-    popen_search(search, &git_grep);
+    result->entries = create_highlighted_line(result, field.text, line_number,
+                                              field.highlights,
+                                              field.nbhighlight);
 }
@@ -0,0 +1,127 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "history.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* weight of the last search in the running averages */
+#define HISTORY_WEIGHT 0.3
+
+/* one "<runs> <first result> <total> <backend> <root>" line per sample, the
+ * root last since it may contain spaces */
+void read_history(struct history_t *history, const char *path) {
+    char line[PATH_MAX + 128];
+    FILE *file = fopen(path, "r");
+
+    history->nbsample = 0;
+    if (!file) return;
+
+    while (history->nbsample < HISTORY_SIZE && fgets(line, sizeof(line), file)) {
+        struct sample_t *sample = &history->samples[history->nbsample];
+        int offset = 0;
+
+        line[strcspn(line, "\n")] = '\0';
+        if (sscanf(line, "%d %lf %lf %31s %n", &sample->runs,
+                   &sample->first_result, &sample->total, sample->backend,
+                   &offset) != 4 || !offset || !line[offset])
+            continue;
+
+        snprintf(sample->root, sizeof(sample->root), "%s", line + offset);
+        history->nbsample++;
+    }
+
+    fclose(file);
+}
+
+/* written to a temporary file first, so that concurrent ngp never read a
+ * truncated history */
+int write_history(struct history_t *history, const char *path) {
+    char temporary[PATH_MAX];
+    int i;
+
+    snprintf(temporary, sizeof(temporary), "%s.%d", path, (int)getpid());
+
+    FILE *file = fopen(temporary, "w");
+    if (!file) return -1;
+
+    for (i = 0; i < history->nbsample; i++) {
+        struct sample_t *sample = &history->samples[i];
+        fprintf(file, "%d %.1f %.1f %s %s\n", sample->runs,
+                sample->first_result, sample->total, sample->backend,
+                sample->root);
+    }
+
+    if (fclose(file) != 0) {
+        remove(temporary);
+        return -1;
+    }
+
+    return rename(temporary, path);
+}
+
+struct sample_t *get_sample(struct history_t *history, const char *root,
+                            const char *backend) {
+    int i;
+
+    for (i = 0; i < history->nbsample; i++) {
+        struct sample_t *sample = &history->samples[i];
+        if (!strcmp(sample->root, root) && !strcmp(sample->backend, backend))
+            return sample;
+    }
+
+    return NULL;
+}
+
+void add_sample(struct history_t *history, const char *root,
+                const char *backend, double first_result, double total) {
+    struct sample_t sample;
+    struct sample_t *previous = get_sample(history, root, backend);
+
+    if (previous) {
+        sample = *previous;
+        sample.first_result += HISTORY_WEIGHT *
+                               (first_result - sample.first_result);
+        sample.total += HISTORY_WEIGHT * (total - sample.total);
+        sample.runs++;
+
+        /* move it to the most recent end */
+        memmove(previous, previous + 1,
+                (history->samples + history->nbsample - previous - 1) *
+                        sizeof(*previous));
+        history->nbsample--;
+    } else {
+        snprintf(sample.root, sizeof(sample.root), "%s", root);
+        snprintf(sample.backend, sizeof(sample.backend), "%s", backend);
+        sample.first_result = first_result;
+        sample.total = total;
+        sample.runs = 1;
+    }
+
+    /* forget the least recently updated sample */
+    if (history->nbsample == HISTORY_SIZE) {
+        memmove(history->samples, history->samples + 1,
+                (HISTORY_SIZE - 1) * sizeof(*history->samples));
+        history->nbsample--;
+    }
+
+    history->samples[history->nbsample++] = sample;
+}
@@ -0,0 +1,50 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <limits.h>
+
+#define HISTORY_SIZE 128
+#define HISTORY_NAME_MAX 32
+
+/* running averages of the searches of a backend below a root, in
+ * milliseconds */
+struct sample_t {
+    char root[PATH_MAX];
+    char backend[HISTORY_NAME_MAX];
+    int runs;
+    double first_result;
+    double total;
+};
+
+/* samples from the least to the most recently updated */
+struct history_t {
+    struct sample_t samples[HISTORY_SIZE];
+    int nbsample;
+};
+
+void read_history(struct history_t *history, const char *path);
+int write_history(struct history_t *history, const char *path);
+struct sample_t *get_sample(struct history_t *history, const char *root,
+                            const char *backend);
+void add_sample(struct history_t *history, const char *root,
+                const char *backend, double first_result, double total);
+
+#endif
@@ -0,0 +1,255 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "json.h"
+
+#include <string.h>
+
+struct json_reader_t {
+    char *cursor;
+    char *end;
+    const char *keys[JSON_MAX_DEPTH];
+    int depth;
+    json_callback_t callback;
+    void *data;
+};
+
+static int parse_value(struct json_reader_t *reader);
+
+static void skip_spaces(struct json_reader_t *reader) {
+    while (reader->cursor < reader->end &&
+           (*reader->cursor == ' ' || *reader->cursor == '\t' ||
+            *reader->cursor == '\n' || *reader->cursor == '\r'))
+        reader->cursor++;
+}
+
+static int parse_hex(const char *cursor) {
+    int value = 0;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        char c = cursor[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9')
+            value |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            value |= c - 'A' + 10;
+        else
+            return -1;
+    }
+
+    return value;
+}
+
+static char *write_utf8(char *write, int code) {
+    if (code < 0x80) {
+        *write++ = code;
+    } else if (code < 0x800) {
+        *write++ = 0xc0 | (code >> 6);
+        *write++ = 0x80 | (code & 0x3f);
+    } else if (code < 0x10000) {
+        *write++ = 0xe0 | (code >> 12);
+        *write++ = 0x80 | ((code >> 6) & 0x3f);
+        *write++ = 0x80 | (code & 0x3f);
+    } else {
+        *write++ = 0xf0 | (code >> 18);
+        *write++ = 0x80 | ((code >> 12) & 0x3f);
+        *write++ = 0x80 | ((code >> 6) & 0x3f);
+        *write++ = 0x80 | (code & 0x3f);
+    }
+
+    return write;
+}
+
+/* decodes the string the cursor is on in place: an escaped sequence never
+ * takes more room than the bytes it stands for */
+static char *parse_string(struct json_reader_t *reader, size_t *length) {
+    char *read = ++reader->cursor;
+    char *write = read;
+    char *string = read;
+
+    while (read < reader->end && *read != '"') {
+        if (*read != '\\') {
+            *write++ = *read++;
+            continue;
+        }
+
+        if (++read >= reader->end) return NULL;
+
+        switch (*read++) {
+            case 'b': *write++ = '\b'; break;
+            case 'f': *write++ = '\f'; break;
+            case 'n': *write++ = '\n'; break;
+            case 'r': *write++ = '\r'; break;
+            case 't': *write++ = '\t'; break;
+            case 'u': {
+                if (reader->end - read < 4) return NULL;
+
+                int code = parse_hex(read);
+                if (code < 0) return NULL;
+                read += 4;
+
+                /* surrogate pair */
+                if (code >= 0xd800 && code < 0xdc00 &&
+                    reader->end - read >= 6 && read[0] == '\\' &&
+                    read[1] == 'u') {
+                    int low = parse_hex(read + 2);
+                    if (low >= 0xdc00 && low < 0xe000) {
+                        code = 0x10000 + ((code - 0xd800) << 10) +
+                               (low - 0xdc00);
+                        read += 6;
+                    }
+                }
+
+                write = write_utf8(write, code);
+            } break;
+            default: *write++ = read[-1]; break;
+        }
+    }
+
+    if (read >= reader->end) return NULL;
+
+    *write = '\0';
+    *length = write - string;
+    reader->cursor = read + 1;
+
+    return string;
+}
+
+static int parse_object(struct json_reader_t *reader) {
+    size_t length;
+
+    reader->cursor++;
+    skip_spaces(reader);
+    if (reader->cursor < reader->end && *reader->cursor == '}') {
+        reader->cursor++;
+        return 1;
+    }
+
+    while (reader->cursor < reader->end) {
+        if (*reader->cursor != '"') return 0;
+
+        char *key = parse_string(reader, &length);
+        if (!key) return 0;
+
+        skip_spaces(reader);
+        if (reader->cursor >= reader->end || *reader->cursor != ':') return 0;
+        reader->cursor++;
+
+        if (reader->depth >= JSON_MAX_DEPTH) return 0;
+        reader->keys[reader->depth++] = key;
+        if (!parse_value(reader)) return 0;
+        reader->depth--;
+
+        skip_spaces(reader);
+        if (reader->cursor >= reader->end) return 0;
+        if (*reader->cursor == '}') {
+            reader->cursor++;
+            return 1;
+        }
+        if (*reader->cursor != ',') return 0;
+        reader->cursor++;
+        skip_spaces(reader);
+    }
+
+    return 0;
+}
+
+static int parse_array(struct json_reader_t *reader) {
+    reader->cursor++;
+    skip_spaces(reader);
+    if (reader->cursor < reader->end && *reader->cursor == ']') {
+        reader->cursor++;
+        return 1;
+    }
+
+    if (reader->depth >= JSON_MAX_DEPTH) return 0;
+    reader->keys[reader->depth++] = NULL;
+
+    while (reader->cursor < reader->end) {
+        if (!parse_value(reader)) return 0;
+
+        skip_spaces(reader);
+        if (reader->cursor >= reader->end) return 0;
+        if (*reader->cursor == ']') {
+            reader->cursor++;
+            reader->depth--;
+            return 1;
+        }
+        if (*reader->cursor != ',') return 0;
+        reader->cursor++;
+    }
+
+    return 0;
+}
+
+static int parse_value(struct json_reader_t *reader) {
+    struct json_value_t value;
+
+    skip_spaces(reader);
+    if (reader->cursor >= reader->end) return 0;
+
+    switch (*reader->cursor) {
+        case '{':
+            return parse_object(reader);
+        case '[':
+            return parse_array(reader);
+        case '"':
+            value.type = JSON_STRING;
+            value.text = parse_string(reader, &value.length);
+            if (!value.text) return 0;
+            break;
+        default: {
+            /* numbers, true, false and null are kept as their text */
+            char *begin = reader->cursor;
+            while (reader->cursor < reader->end &&
+                   !strchr(",}] \t\r\n", *reader->cursor))
+                reader->cursor++;
+
+            if (reader->cursor == begin) return 0;
+
+            value.type = (*begin == '-' || (*begin >= '0' && *begin <= '9'))
+                                 ? JSON_NUMBER
+                                 : JSON_LITERAL;
+            value.length = reader->cursor - begin;
+
+            /* the separator is needed afterwards, copy short values */
+            char buffer[64];
+            if (value.length >= sizeof(buffer)) return 0;
+            memcpy(buffer, begin, value.length);
+            buffer[value.length] = '\0';
+            value.text = buffer;
+
+            reader->callback(reader->data, reader->keys, reader->depth, &value);
+            return 1;
+        }
+    }
+
+    reader->callback(reader->data, reader->keys, reader->depth, &value);
+    return 1;
+}
+
+int parse_json(char *input, size_t length, json_callback_t callback,
+               void *data) {
+    struct json_reader_t reader = {input, input + length, {NULL}, 0,
+                                   callback, data};
+
+    return parse_value(&reader);
+}
@@ -0,0 +1,44 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef JSON_H
+#define JSON_H
+
+#include <stddef.h>
+
+#define JSON_MAX_DEPTH 8
+
+enum json_type_t { JSON_STRING, JSON_NUMBER, JSON_LITERAL };
+
+struct json_value_t {
+    enum json_type_t type;
+    char *text; /* decoded in place, NUL terminated */
+    size_t length;
+};
+
+/* called for every scalar with the keys leading to it, array elements
+ * have a NULL key */
+typedef void (*json_callback_t)(void *data, const char **keys, int depth,
+                                struct json_value_t *value);
+
+/* streams the values of the document held in input to callback without
+ * building any tree, returns 0 on malformed input */
+int parse_json(char *input, size_t length, json_callback_t callback,
+               void *data);
+
+#endif
@@ -20,78 +20,140 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "theme.h"
 
-static void *get_line(struct entry_t *entry, entry_type_t type);
+/* keep only a window of the line around its first match when the line is
+ * longer than the configured maximum, so that the memory used by a single
+ * match stays bounded whatever the input looks like */
+static size_t crop_line(struct result_t *result, size_t length,
+                        const range_t *match, size_t *end) {
+    size_t begin = 0;
+    size_t window = result->line_window;
+    size_t max_length = result->max_line_length;
 
-struct entry_vtable line_vtable = {display_line, is_line_selectable, free_line,
-                                   get_line};
+    *end = length;
+    if (length <= max_length) return begin;
 
-struct entry_t *create_line(struct result_t *result, char *line,
-                            int line_number, range_t match) {
-    int len = strlen(line) + 1;
+    if (window > max_length) window = max_length;
+
+    if (match->begin > window) begin = match->begin - window;
+
+    *end = match->end + window;
+    if (*end > length) *end = length;
+    if (*end - begin > max_length) *end = begin + max_length;
+
+    return begin;
+}
+
+/* highlights are stored after the text, aligned from the start of the line
+ * since entries are allocated pointer aligned */
+static size_t get_highlights_offset(size_t length) {
+    size_t offset = offsetof(struct line_t, entry.data) + length + 1;
+    return (offset + _Alignof(range_t) - 1) & ~(_Alignof(range_t) - 1);
+}
+
+range_t *get_highlights(struct line_t *line) {
+    return (range_t *)((char *)line +
+                       get_highlights_offset(strlen(line->entry.data)));
+}
+
+static struct line_t *new_line(struct result_t *result, char *line,
+                               int line_number, const range_t *matches,
+                               int nbmatch) {
+    range_t no_match = {0, 0};
+    size_t length = strlen(line);
+    size_t end;
+    size_t offset =
+            crop_line(result, length, nbmatch ? &matches[0] : &no_match, &end);
+    int len = end - offset;
     struct line_t *new;
+    int i;
 
-    new = calloc(1, sizeof(struct line_t) + len);
-    strncpy(new->entry.data, line, len);
-    new->opened = 0;
-    new->is_selectable = 1;
+    new = alloc_entry(result,
+                      get_highlights_offset(len) + nbmatch * sizeof(range_t));
+    memcpy(new->entry.data, line + offset, len);
+    new->entry.data[len] = '\0';
+    new->entry.type = LINE_ENTRY;
+    new->entry.opened = 0;
     new->line = line_number;
-    new->highlight.begin = match.begin;
-    new->highlight.end = match.end;
-    result->nbentry++;
+    new->file = result->nbfile - 1;
+    new->length = length;
+    new->offset = offset;
+    new->nbhighlight = 0;
+
+    /* highlights are stored after the text, clipped to the stored window */
+    range_t *highlights = get_highlights(new);
+    for (i = 0; i < nbmatch; i++) {
+        if (matches[i].end <= offset || matches[i].begin >= end) continue;
+
+        range_t *highlight = &highlights[new->nbhighlight++];
+        highlight->begin =
+                matches[i].begin > offset ? matches[i].begin - offset : 0;
+        highlight->end = (matches[i].end < end ? matches[i].end : end) - offset;
+    }
 
-    new->entry.vtable = &line_vtable;
+    return new;
+}
 
-    if (result->entries) {
-        result->entries->next = &new->entry;
-    } else {
-        result->start = &new->entry;
-    }
+struct entry_t *create_highlighted_line(struct result_t *result, char *line,
+                                        int line_number,
+                                        const range_t *matches, int nbmatch) {
+    struct line_t *new = new_line(result, line, line_number, matches, nbmatch);
+    new->entry.is_selectable = 1;
+    add_entry(result, &new->entry);
 
     return &new->entry;
 }
 
+struct entry_t *create_line(struct result_t *result, char *line,
+                            int line_number, range_t match) {
+    return create_highlighted_line(result, line, line_number, &match, 1);
+}
+
 struct entry_t *create_unselectable_line(struct result_t *result, char *line,
                                          int line_number) {
-    range_t no_match = {0, 0};
-    struct entry_t *entry = create_line(result, line, line_number, no_match);
-    struct line_t *new = container_of(entry, struct line_t, entry);
-    new->is_selectable = 0;
+    struct line_t *new = new_line(result, line, line_number, NULL, 0);
+    new->entry.is_selectable = 0;
+    add_entry(result, &new->entry);
 
-    return entry;
+    return &new->entry;
 }
 
 struct entry_t *create_blank_line(struct result_t *result) {
     return create_unselectable_line(result, "", 0);
 }
 
-static int get_integer_as_string(int integer, char *string) {
-    sprintf(string, "%d", integer);
-    return strlen(string) + 1;
-}
+/* a line of file allocated with the entries of result but left out of
+ * them, for the lines scanned once a file is expanded */
+struct entry_t *create_detached_line(struct result_t *result, char *line,
+                                     int line_number, range_t match,
+                                     int file) {
+    struct line_t *new = new_line(result, line, line_number, &match, 1);
+    new->entry.is_selectable = 1;
+    new->entry.next = NULL;
+    new->file = file;
 
-static void hilight_pattern(struct line_t *container, char *line, int y) {
-    char *ptr = (char *)line;
-    char buffer[32];
-    int length = get_integer_as_string(container->line, buffer);
-    move(y, length);
+    return &new->entry;
+}
 
-    /* while (ptr != pattern) { */
-    while (container->highlight.begin > (ptr - line)) {
-        addch(*ptr);
-        ptr++;
-    }
+static void hilight_pattern(struct line_t *container, char *line, int x,
+                            int y) {
+    range_t *highlights = get_highlights(container);
+    int length = strlen(line);
+    int i;
 
-    /* switch color to cyan */
     attron(A_REVERSE);
 
-    if (container->opened)
+    if (container->entry.opened)
         attron(COLOR_PAIR(COLOR_OPENED_LINE));
     else
         attron(COLOR_PAIR(COLOR_HIGHLIGHT));
 
-    length = container->highlight.end - container->highlight.begin;
-    int counter;
-    for (counter = 0; counter < length; counter++, ptr++) addch(*ptr);
+    for (i = 0; i < container->nbhighlight; i++) {
+        if (highlights[i].begin >= length) break;
+
+        int end = highlights[i].end < length ? highlights[i].end : length;
+        mvaddnstr(y, x + highlights[i].begin, line + highlights[i].begin,
+                  end - highlights[i].begin);
+    }
 
     attroff(A_REVERSE);
 }
@@ -134,23 +196,7 @@ void display_line(struct entry_t *entry, struct search_t *search, int y,
     strncpy(cropped_line, line, COLS - length);
     mvprintw(y, length, "%s", cropped_line);
 
-    hilight_pattern(container, cropped_line, y);
+    hilight_pattern(container, cropped_line, length, y);
 
     if (is_cursor_on_entry) attroff(A_REVERSE);
 }
-
-int is_line_selectable(struct entry_t *entry) {
-    struct line_t *line = container_of(entry, struct line_t, entry);
-    return line->is_selectable;
-}
-
-void free_line(struct entry_t *entry) {
-    struct line_t *ptr = container_of(entry, struct line_t, entry);
-    free(ptr);
-}
-
-static void *get_line(struct entry_t *entry, entry_type_t type) {
-    if (type == LINE_ENTRY) return container_of(entry, struct line_t, entry);
-
-    return NULL;
-}
@@ -22,26 +22,34 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #include "entry.h"
 
 typedef struct {
-    size_t begin;
-    size_t end;
+    uint32_t begin;
+    uint32_t end;
 } range_t;
 
+/* highlights parsed from a single line of backend output */
+#define MAX_HIGHLIGHTS 32
+
 struct line_t {
-    int line;
-    int opened;
-    int is_selectable;
-    range_t highlight;
+    uint32_t line;
+    int32_t file;    /* id of the owning file entry, -1 if none */
+    uint32_t length; /* length of the original line */
+    uint32_t offset; /* offset of the stored window in the original line */
+    uint32_t nbhighlight;
     struct entry_t entry;
 };
 
 struct entry_t *create_line(struct result_t *result, char *line,
                             int line_number, range_t match);
+struct entry_t *create_highlighted_line(struct result_t *result, char *line,
+                                        int line_number,
+                                        const range_t *matches, int nbmatch);
 struct entry_t *create_unselectable_line(struct result_t *result, char *line,
                                          int line_number);
 struct entry_t *create_blank_line(struct result_t *result);
+struct entry_t *create_detached_line(struct result_t *result, char *line,
+                                     int line_number, range_t match, int file);
+range_t *get_highlights(struct line_t *line);
 void display_line(struct entry_t *entry, struct search_t *search, int y,
                   int is_cursor_on_entry);
-void free_line(struct entry_t *entry);
-int is_line_selectable(struct entry_t *entry);
 
 #endif
@@ -16,10 +16,17 @@ You should have received a copy of the GNU General Public License
 along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#define _GNU_SOURCE
+
+#include <ctype.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <getopt.h>
+#include <poll.h>
 #include <signal.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "configuration.h"
@@ -33,63 +40,72 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #include "theme.h"
 #include "utils.h"
 
-#define _GNU_SOURCE
-
 #define CURSOR_UP 'k'
 #define CURSOR_DOWN 'j'
 #define PAGE_UP 'K'
 #define PAGE_DOWN 'J'
+#define NEXT_FILE 'l'
+#define PREVIOUS_FILE 'h'
 #define ENTER 'p'
 #define QUIT 'q'
 #define MARK 'm'
+#define FILTER '/'
+#define SEARCH 's'
+#define GROUP 'g'
+#define PREVIEW 'v'
+#define ESCAPE 27
 #define CTRL_D 4
 #define CTRL_U 21
 
+/* milliseconds between two steps of the rolling wheel */
+#define STATUS_INTERVAL 40
+
 #define lock(MUTEX)                                           \
     for (mutex = &MUTEX; mutex && !pthread_mutex_lock(mutex); \
          pthread_mutex_unlock(mutex), mutex = 0)
 
-/* keep a pointer on search_t & display_t for signal handler ONLY */
-static struct search_t *global_search;
 static struct display_t *global_display;
-static struct configuration_t *global_config;
 static pthread_t pid;
 
-void open_entry(struct search_t *search, int index, const char *editor,
-                const char *pattern) {
-    int i;
-    struct entry_t *ptr;
-    struct entry_t *file = search->result->start;
+/* the signal handler only wakes the main loop up, which stops the search
+ * and quits */
+static volatile sig_atomic_t interrupted;
+static int global_wakeup = -1;
+
+void open_entry(struct display_t *display, struct search_t *search,
+                const char *editor, const char *pattern) {
+    struct line_t *line = NULL;
+    struct file_t *file = NULL;
 
     char command[PATH_MAX];
+    char path[PATH_MAX];
     pthread_mutex_t *mutex;
 
-    for (i = 0, ptr = search->result->start; i < index; i++) {
-        ptr = ptr->next;
-        struct file_t *cast_result = get_type(ptr, FILE_ENTRY);
-        if (cast_result) file = &cast_result->entry;
-    }
-
-    struct line_t *line = container_of(ptr, struct line_t, entry);
-
     lock(search->data_mutex) {
-        snprintf(command, sizeof(command), editor, pattern, line->line,
-                 file->data);
+        line = get_type(get_display_entry(display, search,
+                                          display->index + display->cursor),
+                        LINE_ENTRY);
+        if (line) file = get_file(search->result, line->file);
+        if (file) {
+            get_file_path(search->result, file, path, sizeof(path));
+            snprintf(command, sizeof(command), editor, pattern, line->line,
+                     path);
+        }
     }
 
+    /* backends list files that are gone by now or that are not regular
+     * files only in rare cases, so check them once they are opened only */
+    if (!file || !validate_file(path)) return;
+
     if (system(command) < 0) return;
 
-    line->opened = 1;
+    line->entry.opened = 1;
 }
 
 void sig_handler(int signo) {
     if (signo == SIGINT) {
-        pthread_cancel(pid);
-        pthread_join(pid, NULL);
-        stop_ncurses(global_display);
-        free_search(global_search);
-        destroy_configuration(global_config);
-        exit(-1);
+        interrupted = 1;
+        if (write(global_wakeup, "", 1) < 0) return;
     }
 }
 
@@ -107,12 +123,24 @@ void *lookup_thread(void *arg) {
 
     do_search(d);
 
+    pthread_mutex_lock(&d->data_mutex);
     d->status = 0;
+    d->notified = 0;
+    notify_search(d);
+    pthread_mutex_unlock(&d->data_mutex);
+
     closedir(dp);
     return (void *)NULL;
 }
 
-void display_status(struct search_t *search) {
+static long get_time_ms() {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+void display_status(struct display_t *display, struct search_t *search) {
     char *rollingwheel[] = {
             ".  ", ".  ", ".  ", ".  ", "   ", "   ", "   ", "   ", "   ",
             "   ", "   ", "   ", "   ", "   ", "   ", "   ", "   ", "   ",
@@ -122,26 +150,202 @@ void display_status(struct search_t *search) {
             "   ", "   ", "   ", "   ", "   ", "   ", "   ", "   ", "   ",
             "   ", "   ", "   ", "   ", "   ", "   ",
     };
-    static int i = 0;
+
+    static int shown = 0;
+
+    char counter[32];
 
     attron(COLOR_PAIR(COLOR_FILE));
-    if (search->status)
-        mvaddstr(0, COLS - 3, rollingwheel[++i % 60]);
-    else
-        mvaddstr(0, COLS - 5, "");
+    if (search->status) {
+        /* the number of matches keeps going once the page is full */
+        snprintf(counter, sizeof(counter), " %d ",
+                 search->result->nbselectable);
+        mvaddstr(0, COLS - 3 - strlen(counter), counter);
+        mvaddstr(0, COLS - 3, rollingwheel[get_time_ms() / 10 % 60]);
+        shown = 1;
+    } else if (shown) {
+        /* the wheel is drawn over the first row */
+        invalidate_display(display);
+        display_results(display, search, get_page_size(display));
+        shown = 0;
+    }
+}
+
+enum { KEY_IGNORED, KEY_USED, TEXT_CHANGED, PROMPT_CANCELLED };
+
+/* keys typed at a prompt, the ones it does not use are left to navigation */
+static int edit_prompt(struct display_t *display, char *text, size_t size,
+                       int ch) {
+    size_t length = strlen(text);
+
+    switch (ch) {
+        case ESCAPE:
+            display->prompt = PROMPT_NONE;
+            return PROMPT_CANCELLED;
+        case '\n':
+            display->prompt = PROMPT_NONE;
+            return KEY_USED;
+        case KEY_BACKSPACE:
+        case 127:
+        case '\b':
+            if (length == 0) {
+                display->prompt = PROMPT_NONE;
+                return KEY_USED;
+            }
+            text[length - 1] = '\0';
+            return TEXT_CHANGED;
+        default:
+            if (ch >= KEY_MIN) return KEY_IGNORED;
+            if (!isprint(ch) || length + 1 >= size) return KEY_USED;
+            text[length] = ch;
+            text[length + 1] = '\0';
+            return TEXT_CHANGED;
+    }
+}
+
+/* the view follows every key typed at the filter prompt */
+static int edit_filter(struct display_t *display, struct search_t *search,
+                       int ch) {
+    pthread_mutex_t *mutex;
+    int edit = edit_prompt(display, display->filter, sizeof(display->filter),
+                           ch);
+
+    if (edit == PROMPT_CANCELLED) display->filter[0] = '\0';
+
+    if (edit == TEXT_CHANGED || edit == PROMPT_CANCELLED)
+        lock(search->data_mutex) set_display_filter(display, search,
+                                                    display->filter);
+
+    return edit != KEY_IGNORED;
+}
+
+/* stops the search in progress and starts one for pattern, which reuses the
+ * files its native walk found. The results shown stay until the new search
+ * finds some or ends */
+static struct search_t *restart_search(struct search_t *shown,
+                                       struct search_t *running,
+                                       const char *pattern) {
+    struct options_t *options = running->options;
+    pthread_mutex_t *mutex;
+
+    cancel_searches();
+    pthread_join(pid, NULL);
+
+    /* the result keeps the pattern to size the matches of column only
+     * backends */
+    set_pattern(options, pattern);
+    struct search_t *search = create_search(options);
+    search->listing = running->listing;
+    running->listing = NULL;
+
+    if (running != shown) {
+        running->options = NULL;
+        free_search(running);
+    }
+
+    /* the rolling wheel turns until the new results show */
+    lock(shown->data_mutex) shown->status = 1;
+
+    pthread_mutex_init(&search->data_mutex, NULL);
+    search->wakeup_fd = shown->wakeup_fd;
+
+    if (pthread_create(&pid, NULL, lookup_thread, search)) {
+        stop_ncurses(global_display);
+        fprintf(stderr, "ngp: cannot create thread");
+        exit(-1);
+    }
+
+    return search;
+}
+
+static int edit_pattern(struct display_t *display, struct search_t *shown,
+                        struct search_t **running, int ch) {
+    int edit = edit_prompt(display, display->pattern,
+                           sizeof(display->pattern), ch);
+
+    if (edit == TEXT_CHANGED && display->pattern[0])
+        *running = restart_search(shown, *running, display->pattern);
+
+    return edit != KEY_IGNORED;
+}
+
+/* the new search replaces the results shown once it has some or ends */
+static struct search_t *replace_search(struct display_t *display,
+                                       struct search_t *shown,
+                                       struct search_t *running) {
+    pthread_mutex_t *mutex;
+    int ready = 0;
+
+    lock(running->data_mutex) {
+        running->notified = 0;
+        ready = running->result->nbentry > 0 || running->status == 0;
+        if (ready) {
+            /* the view points to the entries of the results replaced */
+            free_view(display->view);
+            display->view = NULL;
+            set_display_filter(display, running, display->filter);
+        }
+    }
+
+    if (!ready) return shown;
+
+    shown->options = NULL;
+    free_search(shown);
+
+    return running;
+}
+
+/* draws the results published since the last frame, returns 0 once the
+ * search is over without any result or has failed */
+static int draw_frame(struct display_t *display, struct search_t *search,
+                      struct configuration_t *config) {
+    pthread_mutex_t *mutex;
+    int found = 1;
+
+    lock(search->data_mutex) {
+        search->notified = 0;
+        if (search->result->nbentry != 0 && !display->ncurses_initialized) {
+            start_ncurses(display, config);
+            display->ncurses_initialized = 1;
+        }
+        display_results(display, search, get_page_size(display));
+        display_status(display, search);
+        display_prompt(display, search);
+
+        if (search->status == 0 &&
+            (search->result->nbentry == 0 || search->error[0]))
+            found = 0;
+    }
+
+    if (display->ncurses_initialized) refresh();
+
+    return found;
 }
 
 int main(int argc, char *argv[]) {
     struct configuration_t *config = create_configuration();
     struct options_t *options = create_options(config, argc, argv);
     struct search_t *search = create_search(options);
-    global_search = search;
+    struct search_t *running = search;
     pthread_mutex_init(&search->data_mutex, NULL);
 
     struct display_t *display;
     display = create_display();
     global_display = display;
-    global_config = config;
+
+    /* files only searches are shown grouped */
+    display->grouped = options->files_option;
+    if (display->grouped) set_display_filter(display, search, "");
+
+    /* the search thread wakes the loop below up through a pipe */
+    int wakeup[2];
+    if (pipe2(wakeup, O_CLOEXEC | O_NONBLOCK)) {
+        fprintf(stderr, "ngp: cannot create pipe");
+        free_search(search);
+        exit(-1);
+    }
+    search->wakeup_fd = wakeup[1];
+    global_wakeup = wakeup[1];
 
     signal(SIGINT, sig_handler);
     if (pthread_create(&pid, NULL, lookup_thread, search)) {
@@ -151,79 +355,163 @@ int main(int argc, char *argv[]) {
     }
 
     pthread_mutex_t *mutex;
-    lock(search->data_mutex) display_results(display, search, LINES);
-
+    lock(search->data_mutex)
+            display_results(display, search, get_page_size(display));
+
+    struct pollfd fds[] = {{wakeup[0], POLLIN, 0}, {STDIN_FILENO, POLLIN, 0}};
+    long frame_interval = 1000 / options->frame_rate;
+    long last_frame = 0;
+    int pending = 0;
+    int queried = 0;
+    int toggled = 0;
+    char drain[64];
     int ch;
-    while ((ch = getch())) {
-        switch (ch) {
-            case KEY_RESIZE:
-                lock(search->data_mutex) resize_display(display, search, LINES);
-                break;
-            case CURSOR_DOWN:
-            case KEY_DOWN:
-                lock(search->data_mutex)
-                        move_cursor_down_and_refresh(display, search);
-                break;
-            case CURSOR_UP:
-            case KEY_UP:
-                lock(search->data_mutex)
-                        move_cursor_up_and_refresh(display, search);
-                break;
-            case KEY_PPAGE:
-            case PAGE_UP:
-            case CTRL_U:
-                lock(search->data_mutex)
-                        move_page_up_and_refresh(display, search);
-                break;
-            case KEY_NPAGE:
-            case PAGE_DOWN:
-            case CTRL_D:
-                lock(search->data_mutex)
-                        move_page_down_and_refresh(display, search);
-                break;
-            case ENTER:
-            case '\n':
-                if (search->result->nbentry == 0) break;
-                stop_ncurses(display);
-                open_entry(search, display->cursor + display->index,
-                           search->options->editor, search->options->pattern);
-                start_ncurses(display, config);
-                resize_display(display, search, LINES);
-                break;
-            case QUIT:
-                goto quit;
-            default:
-                break;
-        }
 
-        // disable no-delay mode after search was finished
-        if (search->status == 0) {
-            nodelay(stdscr, FALSE);
-        } else {
-            usleep(10000);
+    for (;;) {
+        long now = get_time_ms();
+        int timeout = -1;
+
+        /* the results published meanwhile are drawn frame_interval apart
+         * at most and the rolling wheel turns while the search runs,
+         * nothing wakes up otherwise */
+        if (pending)
+            timeout = last_frame + frame_interval - now;
+        else if (search->status)
+            timeout = STATUS_INTERVAL;
+
+        /* keys are read by ncurses once it shows the first results */
+        if (poll(fds, display->ncurses_initialized ? 2 : 1,
+                 timeout < 0 && pending ? 0 : timeout) > 0 &&
+            fds[0].revents & POLLIN) {
+            while (read(wakeup[0], drain, sizeof(drain)) > 0)
+                ;
+            pending = 1;
         }
 
-        lock(search->data_mutex) {
-            display_results(display, search, LINES);
-            display_status(search);
-            if (search->result->nbentry != 0 && !display->ncurses_initialized) {
-                start_ncurses(display, config);
-                display->ncurses_initialized = 1;
+        if (interrupted) goto quit;
+
+        while (display->ncurses_initialized && (ch = getch()) != ERR) {
+            if ((display->prompt == PROMPT_FILTER &&
+                 edit_filter(display, search, ch)) ||
+                (display->prompt == PROMPT_PATTERN &&
+                 edit_pattern(display, search, &running, ch))) {
+                pending = 1;
+                last_frame = 0;
+                continue;
+            }
+
+            switch (ch) {
+                case KEY_RESIZE:
+                    lock(search->data_mutex) resize_display(
+                            display, search, get_page_size(display));
+                    break;
+                case FILTER:
+                    display->prompt = PROMPT_FILTER;
+                    break;
+                case SEARCH:
+                    snprintf(display->pattern, sizeof(display->pattern), "%s",
+                             options->pattern);
+                    display->prompt = PROMPT_PATTERN;
+                    queried = 1;
+                    break;
+                case CURSOR_DOWN:
+                case KEY_DOWN:
+                    lock(search->data_mutex)
+                            move_cursor_down_and_refresh(display, search);
+                    break;
+                case CURSOR_UP:
+                case KEY_UP:
+                    lock(search->data_mutex)
+                            move_cursor_up_and_refresh(display, search);
+                    break;
+                case KEY_PPAGE:
+                case PAGE_UP:
+                case CTRL_U:
+                    lock(search->data_mutex)
+                            move_page_up_and_refresh(display, search);
+                    break;
+                case KEY_NPAGE:
+                case PAGE_DOWN:
+                case CTRL_D:
+                    lock(search->data_mutex)
+                            move_page_down_and_refresh(display, search);
+                    break;
+                case NEXT_FILE:
+                case KEY_RIGHT:
+                    lock(search->data_mutex)
+                            move_next_file_and_refresh(display, search);
+                    break;
+                case PREVIOUS_FILE:
+                case KEY_LEFT:
+                    lock(search->data_mutex)
+                            move_previous_file_and_refresh(display, search);
+                    break;
+                case GROUP:
+                    /* the lines of a files only search are read once their
+                     * file is expanded only */
+                    if (options->files_option) break;
+                    lock(search->data_mutex) {
+                        display->grouped = !display->grouped;
+                        set_display_filter(display, search, display->filter);
+                    }
+                    break;
+                case PREVIEW:
+                    lock(search->data_mutex) toggle_display_preview(display);
+                    break;
+                case ENTER:
+                case '\n':
+                    if (get_display_count(display, search) == 0) break;
+                    lock(search->data_mutex) toggled =
+                            toggle_display_group(display, search);
+                    if (toggled) break;
+                    stop_ncurses(display);
+                    open_entry(display, search, search->options->editor,
+                               search->options->pattern);
+                    if (display->preview) clear_preview(display->preview);
+                    start_ncurses(display, config);
+                    resize_display(display, search, get_page_size(display));
+                    break;
+                case QUIT:
+                    goto quit;
+                default:
+                    break;
             }
+            pending = 1;
+            last_frame = 0;
         }
 
-        lock(search->data_mutex) {
-            if (search->status == 0 && search->result->nbentry == 0) {
+        now = get_time_ms();
+        if ((pending && now - last_frame >= frame_interval) ||
+            (!pending && search->status)) {
+            if (running != search) search = replace_search(display, search,
+                                                           running);
+            if (!draw_frame(display, search, config) &&
+                (!queried || search->error[0]))
                 goto quit;
-            }
+            last_frame = now;
+            pending = 0;
         }
     }
 
 quit:
-    pthread_cancel(pid);
+    /* the search stops at its next file, chunk or block of output */
+    cancel_searches();
     pthread_join(pid, NULL);
     stop_ncurses(display);
+    if (running != search) {
+        running->options = NULL;
+        free_search(running);
+    }
+
+    int status = interrupted ? -1 : 0;
+    if (search->error[0]) {
+        fprintf(stderr, "%s\n", search->error);
+        status = 1;
+    }
+
     free_search(search);
     destroy_configuration(config);
-    return 0;
+    close(wakeup[0]);
+    close(wakeup[1]);
+    return status;
 }
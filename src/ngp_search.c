@@ -23,18 +23,57 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include "batch.h"
 #include "entry.h"
 #include "file.h"
 #include "line.h"
 #include "list.h"
+#include "search_utils.h"
 #include "utils.h"
 
 #define for_lock(MUTEX)                                       \
     for (mutex = &MUTEX; mutex && !pthread_mutex_lock(mutex); \
          pthread_mutex_unlock(mutex), mutex = 0)
 
+#define JOB_QUEUE_SIZE 256
+#define REORDER_WINDOW 256
+
+/* a stale search stops parsing a file after that many lines at most */
+#define STALE_CHECK_LINES 4096
+
+/* files are looked up by the calling thread and parsed by a pool of workers,
+ * each job being the batch of the file it parses */
+struct pool_t {
+    struct search_t *search;
+    parser_t parser;
+    const char *pattern;
+
+    /* records the files submitted when not NULL */
+    struct listing_t *listing;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t job_available;
+    pthread_cond_t space_available;
+
+    pthread_t *workers;
+    int nbworker;
+
+    struct batch_t *jobs[JOB_QUEUE_SIZE];
+    int first_job;
+    int nbjob;
+    int done;
+    int stop;
+
+    /* sorted mode */
+    int ordered;
+    int sequence;
+    int next_sequence;
+    struct batch_t *pending[REORDER_WINDOW];
+};
+
 static int is_simlink(char *file_path) {
     struct stat filestat;
 
@@ -71,15 +110,32 @@ char *get_file_name(const char *absolute_path, char *file_name) {
     return ret;
 }
 
-static void parse_text(struct search_t *search, const parser_t parser, const char *file_name,
-                       int file_size, const char *text, const char *pattern) {
+/* returns whether line matches, with the range of its match */
+static int match_line(struct search_t *search, const parser_t parser,
+                      const char *line, const char *pattern, range_t *match) {
+    char *match_begin = parser(search->options, line, pattern);
+    if (match_begin == NULL) return 0;
+
+    if (search->options->regexp_option) {
+        match->begin = strstr(line, match_begin) - line;
+        match->end = match->begin + strlen(match_begin);
+        pcre_free_substring(match_begin);
+    } else {
+        match->begin = match_begin - line;
+        match->end = match->begin + strlen(search->options->pattern);
+    }
+
+    return 1;
+}
+
+static void parse_text(struct search_t *search, const parser_t parser,
+                       struct batch_t *batch, int file_size, const char *text,
+                       const char *pattern) {
     char *end;
     char *endline;
-    int first_occurrence;
     int line_number;
     char *pointer = (char *)text;
 
-    first_occurrence = 1;
     line_number = 1;
     end = pointer + file_size;
 
@@ -87,29 +143,19 @@ static void parse_text(struct search_t *search, const parser_t parser, const cha
 
         if (pointer == end) break;
 
+        if (line_number % STALE_CHECK_LINES == 0 && !batch->whole_file &&
+            is_search_stale(search))
+            break;
+
         endline = memchr(pointer, '\n', end - pointer);
         if (endline == NULL) break;
 
         *endline = '\0';
 
-        char *match_begin = parser(search->options, pointer, pattern);
-        if (match_begin != NULL) {
-            if (first_occurrence) {
-                search->result->entries =
-                        create_file(search->result, (char *)file_name);
-                first_occurrence = 0;
-            }
-            range_t match = {0, 0};
-            if (search->options->regexp_option) {
-                match.begin = strstr(pointer, match_begin) - pointer;
-                match.end = match.begin + strlen(match_begin);
-            } else {
-                match.begin = match_begin - pointer;
-                match.end = match.begin + strlen(search->options->pattern);
-            }
-            search->result->entries =
-                    create_line(search->result, pointer, line_number, match);
-        }
+        range_t match = {0, 0};
+        if (match_line(search, parser, pointer, pattern, &match))
+            add_batch_line(batch, pointer, endline - pointer, line_number,
+                           match);
 
         *endline = '\n';
         pointer = endline + 1;
@@ -157,14 +203,14 @@ static int is_extension_good(struct options_t *options, const char *file) {
 }
 
 static int parse_file(struct search_t *search, const parser_t parser,
-                      const char *file, const char *pattern) {
+                      struct batch_t *batch, const char *pattern) {
     int f;
     char *pointer;
     char *start;
     struct stat sb;
     errno = 0;
 
-    f = open(file, O_RDONLY);
+    f = open(batch->file, O_RDONLY);
     if (f < 0) return -1;
 
     if (fstat(f, &sb) < 0) {
@@ -181,42 +227,214 @@ static int parse_file(struct search_t *search, const parser_t parser,
 
     close(f);
 
-    parse_text(search, parser, file, sb.st_size, start, pattern);
+    parse_text(search, parser, batch, sb.st_size, start, pattern);
 
     if (munmap(start, sb.st_size) < 0) return -1;
 
     return 0;
 }
 
-static void lookup_file(struct search_t *search, const parser_t parser,
-                        const char *file, const char *pattern) {
-    errno = 0;
+/* the matching lines of a file only counted by a files only search. The
+ * options shared with the searches restarted since may hold another
+ * pattern, the one of the result counted is read with a regex of its own */
+struct batch_t *scan_file(struct search_t *search, const char *path) {
+    struct options_t *options = malloc(sizeof(*options));
+    struct search_t scan = {.result = search->result, .options = options};
+    struct batch_t *batch = create_batch(path, 0);
+
+    *options = *search->options;
+    snprintf(options->pattern, sizeof(options->pattern), "%s",
+             search->result->pattern);
+    options->incase_option = search->result->incase;
+    options->pcre_compiled = NULL;
+    options->pcre_extra = NULL;
+
+    batch->whole_file = 1;
+    parse_file(&scan, from_options_to_parser(options), batch,
+               options->pattern);
+
+    if (options->pcre_compiled) pcre_free((void *)options->pcre_compiled);
+    if (options->pcre_extra) pcre_free((void *)options->pcre_extra);
+    free(options);
+
+    return batch;
+}
+
+static void publish_batch(struct search_t *search, struct batch_t *batch) {
     pthread_mutex_t *mutex;
 
-    if (is_ignored_file(search->options, file) && !search->options->raw_option)
-        return;
+    for_lock(search->data_mutex) {
+        commit_batch(search->result, batch);
+        notify_search(search);
+    }
+}
 
-    if (search->options->raw_option) {
-        for_lock(search->data_mutex) parse_file(search, parser, file, pattern);
+/* hand the batch over to the result: in sorted mode batches are kept in a
+ * reorder buffer and released by increasing sequence only */
+static void complete_batch(struct pool_t *pool, struct batch_t *batch) {
+    struct search_t *search = pool->search;
+
+    if (!pool->ordered) {
+        publish_batch(search, batch);
+        free_batch(batch);
         return;
     }
 
-    if (is_specific_file(search->options, file)) {
-        for_lock(search->data_mutex) parse_file(search, parser, file, pattern);
-        return;
+    pthread_mutex_lock(&pool->mutex);
+
+    pool->pending[batch->sequence % REORDER_WINDOW] = batch;
+
+    while ((batch = pool->pending[pool->next_sequence % REORDER_WINDOW])) {
+        pool->pending[pool->next_sequence % REORDER_WINDOW] = NULL;
+        pool->next_sequence++;
+
+        publish_batch(search, batch);
+        free_batch(batch);
     }
 
-    if (is_extension_good(search->options, file)) {
-        for_lock(search->data_mutex) parse_file(search, parser, file, pattern);
-        return;
+    pthread_cond_broadcast(&pool->space_available);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void *worker_thread(void *arg) {
+    struct pool_t *pool = arg;
+
+    while (1) {
+        pthread_mutex_lock(&pool->mutex);
+
+        while (!pool->nbjob && !pool->done && !pool->stop)
+            pthread_cond_wait(&pool->job_available, &pool->mutex);
+
+        if (pool->stop || !pool->nbjob) {
+            pthread_mutex_unlock(&pool->mutex);
+            break;
+        }
+
+        struct batch_t *batch = pool->jobs[pool->first_job];
+        pool->first_job = (pool->first_job + 1) % JOB_QUEUE_SIZE;
+        pool->nbjob--;
+
+        pthread_cond_signal(&pool->space_available);
+        pthread_mutex_unlock(&pool->mutex);
+
+        /* a stale search still completes its batches, empty, for the
+         * sorted mode not to wait for them */
+        if (!is_search_stale(pool->search))
+            parse_file(pool->search, pool->parser, batch, pool->pattern);
+        complete_batch(pool, batch);
+    }
+
+    return NULL;
+}
+
+static void submit_file(struct pool_t *pool, const char *file) {
+    pthread_mutex_lock(&pool->mutex);
+
+    while (pool->nbjob == JOB_QUEUE_SIZE ||
+           (pool->ordered &&
+            pool->sequence - pool->next_sequence >= REORDER_WINDOW))
+        pthread_cond_wait(&pool->space_available, &pool->mutex);
+
+    int last_job = (pool->first_job + pool->nbjob) % JOB_QUEUE_SIZE;
+    pool->jobs[last_job] = create_batch(file, pool->sequence++);
+    pool->jobs[last_job]->count_only = pool->search->options->files_option;
+    pool->nbjob++;
+
+    pthread_cond_signal(&pool->job_available);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void add_listed_path(struct listing_t *listing, const char *path) {
+    size_t length = strlen(path) + 1;
+
+    if (listing->used + length > listing->size) {
+        listing->size = listing->size ? listing->size * 2 : 1 << 16;
+        if (listing->size < listing->used + length)
+            listing->size = listing->used + length;
+        listing->paths = realloc(listing->paths, listing->size);
+    }
+
+    memcpy(listing->paths + listing->used, path, length);
+    listing->used += length;
+}
+
+static int is_file_wanted(struct options_t *options, const char *file) {
+    if (is_ignored_file(options, file) && !options->raw_option) return 0;
+
+    if (options->raw_option) return 1;
+
+    if (is_specific_file(options, file)) return 1;
+
+    return is_extension_good(options, file);
+}
+
+static void lookup_file(struct pool_t *pool, const char *file) {
+    errno = 0;
+
+    if (!is_file_wanted(pool->search->options, file)) return;
+
+    if (pool->listing) add_listed_path(pool->listing, file);
+    submit_file(pool, file);
+}
+
+/* order directory entries so that a depth first walk visits paths in sorted
+ * order: a directory name compares as if it was followed by a '/' */
+static int compare_paths(const struct dirent **first,
+                         const struct dirent **second) {
+    const unsigned char *a = (const unsigned char *)(*first)->d_name;
+    const unsigned char *b = (const unsigned char *)(*second)->d_name;
+
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+
+    int ca = *a ? *a : ((*first)->d_type == DT_DIR ? '/' : 0);
+    int cb = *b ? *b : ((*second)->d_type == DT_DIR ? '/' : 0);
+
+    return ca - cb;
+}
+
+static void lookup_directory(struct pool_t *pool, const char *dir);
+
+static void lookup_entry(struct pool_t *pool, const char *dir,
+                         struct dirent *ep) {
+    if (is_search_stale(pool->search)) return;
+
+    if (!(ep->d_type & DT_DIR)) {
+        char file_path[PATH_MAX];
+        snprintf(file_path, PATH_MAX, "%s/%s", dir, ep->d_name);
+
+        if (!is_simlink(file_path)) {
+            lookup_file(pool, file_path);
+        }
+    }
+
+    if (ep->d_type & DT_DIR && is_dir_good(ep->d_name)) {
+        char path_dir[PATH_MAX] = "";
+        snprintf(path_dir, PATH_MAX, "%s/%s", dir, ep->d_name);
+        lookup_directory(pool, path_dir);
     }
 }
 
-static void lookup_directory(struct search_t *search, const parser_t parser,
-                             const char *dir, const char *pattern) {
+static void lookup_directory(struct pool_t *pool, const char *dir) {
     DIR *dp;
 
-    if (is_ignored_file(search->options, dir)) {
+    if (is_ignored_file(pool->search->options, dir)) {
+        return;
+    }
+
+    if (pool->ordered) {
+        struct dirent **entries;
+        int nbentry = scandir(dir, &entries, NULL, compare_paths);
+        int i;
+
+        for (i = 0; i < nbentry; i++) {
+            lookup_entry(pool, dir, entries[i]);
+            free(entries[i]);
+        }
+
+        if (nbentry >= 0) free(entries);
         return;
     }
 
@@ -229,28 +447,231 @@ static void lookup_directory(struct search_t *search, const parser_t parser,
 
         if (!ep) break;
 
-        if (!(ep->d_type & DT_DIR)) {
-            char file_path[PATH_MAX];
-            snprintf(file_path, PATH_MAX, "%s/%s", dir, ep->d_name);
+        lookup_entry(pool, dir, ep);
+    }
+    closedir(dp);
+}
+
+/* let the workers drain the queue, or drop it when stopping */
+static void stop_pool(struct pool_t *pool, int stop) {
+    int i;
 
-            if (!is_simlink(file_path)) {
-                lookup_file(search, parser, file_path, pattern);
-            }
-        }
+    pthread_mutex_lock(&pool->mutex);
+    pool->done = 1;
+    pool->stop = stop;
+    pthread_cond_broadcast(&pool->job_available);
+    pthread_mutex_unlock(&pool->mutex);
 
-        if (ep->d_type & DT_DIR && is_dir_good(ep->d_name)) {
-            char path_dir[PATH_MAX] = "";
-            snprintf(path_dir, PATH_MAX, "%s/%s", dir, ep->d_name);
-            lookup_directory(search, parser, path_dir, pattern);
-        }
+    for (i = 0; i < pool->nbworker; i++) pthread_join(pool->workers[i], NULL);
+
+    for (i = 0; i < pool->nbjob; i++)
+        free_batch(pool->jobs[(pool->first_job + i) % JOB_QUEUE_SIZE]);
+
+    for (i = 0; i < REORDER_WINDOW; i++)
+        if (pool->pending[i]) free_batch(pool->pending[i]);
+
+    pthread_cond_destroy(&pool->job_available);
+    pthread_cond_destroy(&pool->space_available);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->workers);
+}
+
+static void start_pool(struct pool_t *pool, struct search_t *search,
+                       int ordered) {
+    memset(pool, 0, sizeof(*pool));
+    pool->search = search;
+    pool->parser = from_options_to_parser(search->options);
+    pool->pattern = search->options->pattern;
+    pool->ordered = ordered;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->job_available, NULL);
+    pthread_cond_init(&pool->space_available, NULL);
+
+    /* compile the regexp once before workers share it */
+    if (search->options->regexp_option) {
+        char *match = regex(search->options, "", pool->pattern);
+        if (match) pcre_free_substring(match);
     }
-    closedir(dp);
+
+    pool->nbworker = get_thread_count(search->options);
+    pool->workers = calloc(pool->nbworker, sizeof(*pool->workers));
+
+    int i;
+    for (i = 0; i < pool->nbworker; i++)
+        pthread_create(&pool->workers[i], NULL, worker_thread, pool);
+}
+
+static void submit_listing(struct pool_t *pool, struct listing_t *listing) {
+    size_t offset;
+
+    for (offset = 0; offset < listing->used && !is_search_stale(pool->search);
+         offset += strlen(listing->paths + offset) + 1)
+        submit_file(pool, listing->paths + offset);
 }
 
 void do_ngp_search(struct search_t *search) {
+    struct listing_t *listing = search->listing;
+    struct pool_t pool;
+
+    start_pool(&pool, search, search->options->sort_option);
+
+    if (listing && listing->complete) {
+        submit_listing(&pool, listing);
+    } else {
+        if (!listing) listing = search->listing = calloc(1, sizeof(*listing));
+        listing->used = 0;
+
+        pool.listing = listing;
+        lookup_directory(&pool, search->options->directory);
+        listing->complete = !is_search_stale(search);
+    }
+
+    stop_pool(&pool, is_search_stale(search));
+}
 
-    parser_t parser = from_options_to_parser(search->options);
+/* in hybrid mode, git grep reads the files of the index while the pool
+ * parses the untracked ones listed by git ls-files. git only selects the
+ * lines, their matches are computed like in nat so that both look alike */
+struct tracked_t {
+    struct search_t *search;
+    parser_t parser;
+    char *argv[MAX_ARGUMENTS];
+    struct batch_t *batch;
+    int wanted;
+    int status;
+
+    pthread_t thread;
+};
+
+static int is_path_ignored(struct options_t *options, const char *path) {
+    char component[PATH_MAX];
+
+    if (options->raw_option) return 0;
+
+    while (*path) {
+        const char *end = strchr(path, '/');
+        if (!end) end = path + strlen(path);
+        snprintf(component, sizeof(component), "%.*s", (int)(end - path),
+                 path);
+        if (is_ignored_file(options, component)) return 1;
+
+        path = *end ? end + 1 : end;
+    }
+
+    return 0;
+}
+
+static void flush_tracked(struct tracked_t *tracked) {
+    if (!tracked->batch) return;
+
+    publish_batch(tracked->search, tracked->batch);
+    free_batch(tracked->batch);
+    tracked->batch = NULL;
+}
+
+/* "<file>\0<line>\0<text>" records of git grep -z -n */
+static void parse_tracked_line(void *data, char *record, size_t length) {
+    struct tracked_t *tracked = data;
+    struct options_t *options = tracked->search->options;
+    char *end = record + length;
+    range_t match = {0, 0};
+
+    char *number = memchr(record, '\0', length);
+    if (!number) return;
+
+    char *text = memchr(number + 1, '\0', end - number - 1);
+    if (!text) return;
+
+    if (!tracked->batch || strcmp(tracked->batch->file, record)) {
+        flush_tracked(tracked);
+        tracked->batch = create_batch(record, 0);
+        tracked->wanted = is_file_wanted(options, record) &&
+                          !is_path_ignored(options, record);
+    }
+
+    if (!tracked->wanted) return;
+
+    if (match_line(tracked->search, tracked->parser, text + 1,
+                   options->pattern, &match))
+        add_batch_line(tracked->batch, text + 1, end - text - 1,
+                       atoi(number + 1), match);
+}
+
+static void *tracked_thread(void *arg) {
+    struct tracked_t *tracked = arg;
+
+    tracked->status = run_command(tracked->argv, '\n', tracked->search, NULL,
+                                  parse_tracked_line, tracked);
+
+    flush_tracked(tracked);
+    free_argv(tracked->argv);
+    return NULL;
+}
+
+static void lookup_listed_file(void *data, char *file, size_t length) {
+    struct pool_t *pool = data;
+
+    if (is_search_stale(pool->search)) return;
+
+    if (is_simlink(file) || is_path_ignored(pool->search->options, file))
+        return;
+
+    /* git lists a nested repository as a directory, which nat walks */
+    if (length > 1 && file[length - 1] == '/') {
+        file[length - 1] = '\0';
+        if (pool->search->every_file) lookup_directory(pool, file);
+        return;
+    }
+
+    lookup_file(pool, file);
+}
+
+void do_hybrid_search(struct search_t *search) {
+    struct options_t *options = search->options;
+    struct tracked_t tracked;
+    struct pool_t pool;
+    int status;
+    char git_options[LINE_MAX];
+    char *untracked[] = {"git",  "ls-files",         "-z", "--others",
+                         "--exclude-standard", "--", options->directory,
+                         NULL};
+    char *every_untracked[] = {"git", "ls-files", "-z", "--others", "--",
+                               options->directory, NULL};
+    char *cached[] = {"git", "ls-files", "-z", "--cached", "--",
+                      options->directory, NULL};
+
+    /* git selects the lines with the same semantics as nat */
+    snprintf(git_options, sizeof(git_options), "-z -n %s --no-color %s %s",
+             search->every_file ? "-a" : "-I",
+             options->incase_option ? "-i" : "",
+             options->regexp_option ? "-P" : "-F");
+
+    memset(&tracked, 0, sizeof(tracked));
+    tracked.search = search;
+    tracked.parser = from_options_to_parser(options);
+    tracked.status = -1;
+    build_argv(options->parsers[GIT_SEARCH].command, git_options,
+               options->pattern, options->directory, tracked.argv);
+
+    start_pool(&pool, search, 0);
+    pthread_create(&tracked.thread, NULL, tracked_thread, &tracked);
+
+    status = run_command(search->every_file ? every_untracked : untracked,
+                         '\0', search, NULL, lookup_listed_file, &pool);
+    pthread_join(tracked.thread, NULL);
+
+    if (is_search_stale(search)) {
+        stop_pool(&pool, 1);
+        return;
+    }
+
+    if (status != 0) {
+        /* not a git work tree, nat does it all */
+        lookup_directory(&pool, options->directory);
+    } else if (!WIFEXITED(tracked.status) || WEXITSTATUS(tracked.status) > 1) {
+        /* git grep failed, let nat parse the tracked files too */
+        run_command(cached, '\0', search, NULL, lookup_listed_file, &pool);
+    }
 
-    lookup_directory(search, parser, search->options->directory,
-                     search->options->pattern);
+    stop_pool(&pool, is_search_stale(search));
 }
@@ -19,6 +19,10 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef NGP_SEARCH_H
 #define NGP_SEARCH_H
 
+struct batch_t;
+struct search_t;
+
 char *get_file_name(const char *absolute_path, char *file_name);
+struct batch_t *scan_file(struct search_t *search, const char *path);
 
 #endif  // NGP_SEARCH_N
@@ -56,6 +56,16 @@ static void usage(int status) {
     fprintf(out,
             " --git[=<git-grep-options>]  use git-grep as parser (works only "
             "within GIT repositories)\n");
+    fprintf(out,
+            " --rg[=<rg-options>]         use ripgrep as parser\n");
+    fprintf(out,
+            " --hybrid[=<nat-options>]    use git-grep for tracked files and "
+            "nat for untracked ones\n");
+    fprintf(out,
+            " --auto[=<nat-options>]      pick nat or hybrid from the tree "
+            "and past searches\n");
+    fprintf(out,
+            " --parser=<name>             use a parser defined in ngprc\n");
     fprintf(out, "\n");
     fprintf(out, "nat-options:\n");
     fprintf(out, " -i         ignore case distinctions in pattern\n");
@@ -63,6 +73,10 @@ static void usage(int status) {
     fprintf(out, " -t <type>  look into files with specified <type>\n");
     fprintf(out, " -I <name>  ignore file/dir with specified <name>\n");
     fprintf(out, " -e         pattern is a regular expression\n");
+    fprintf(out, " -s         sort files by path (deterministic output)\n");
+    fprintf(out,
+            " -l         list files with their number of matches, lines "
+            "are read when a file is expanded\n");
     exit(status);
 }
 
@@ -71,6 +85,86 @@ static void display_version(void) {
     exit(0);
 }
 
+static void set_parser(external_parser_t *parser, const char *name,
+                       const char *command, const char *arguments,
+                       const struct format_t *format) {
+    free(parser->name);
+    free(parser->command);
+    free(parser->default_arguments);
+
+    parser->name = strdup(name);
+    parser->command = strdup(command);
+    parser->default_arguments = strdup(arguments);
+    parser->format = format;
+}
+
+/* nat and hybrid searches both take the nat options */
+static int has_nat_options(struct options_t *options) {
+    return options->search_type == NGP_SEARCH ||
+           options->search_type == HYBRID_SEARCH ||
+           options->search_type == AUTO_SEARCH;
+}
+
+static int find_parser(struct options_t *options, const char *name) {
+    int i;
+
+    if (!strcmp(name, "nat")) return NGP_SEARCH;
+
+    for (i = NGP_SEARCH + 1; i < options->nbparser; i++)
+        if (!strcmp(options->parsers[i].name, name)) return i;
+
+    return -1;
+}
+
+/* parsers = ({ name = "..."; command = "..."; format = "..."; arguments =
+ * "..."; }, ...), redefining a parser by name replaces it */
+static void read_parsers(config_t *cfg, struct options_t *options) {
+    config_setting_t *parsers = config_lookup(cfg, "parsers");
+    const char *name, *command, *format_name;
+    const char *arguments;
+    int i;
+
+    if (!parsers) return;
+
+    for (i = 0; i < config_setting_length(parsers); i++) {
+        config_setting_t *parser = config_setting_get_elem(parsers, i);
+
+        if (!config_setting_lookup_string(parser, "name", &name) ||
+            !config_setting_lookup_string(parser, "command", &command) ||
+            !config_setting_lookup_string(parser, "format", &format_name)) {
+            fprintf(stderr, "ngprc: parser #%d needs a name, a command and "
+                            "a format!\n", i + 1);
+            exit(-1);
+        }
+
+        if (!config_setting_lookup_string(parser, "arguments", &arguments))
+            arguments = "";
+
+        const struct format_t *format = get_format(format_name);
+        if (!format) {
+            fprintf(stderr, "ngprc: unknown format \"%s\" for parser %s!\n",
+                    format_name, name);
+            exit(-1);
+        }
+
+        int index = find_parser(options, name);
+        if (index == NGP_SEARCH) {
+            fprintf(stderr, "ngprc: parser name \"nat\" is reserved!\n");
+            exit(-1);
+        }
+
+        if (index < 0) {
+            if (options->nbparser == MAX_PARSERS) {
+                fprintf(stderr, "ngprc: too many parsers!\n");
+                exit(-1);
+            }
+            index = options->nbparser++;
+        }
+
+        set_parser(&options->parsers[index], name, command, arguments, format);
+    }
+}
+
 #ifndef read_config /* ignore for testing */
 static void read_config(struct configuration_t *config,
                         struct options_t *options) {
@@ -90,29 +184,46 @@ static void read_config(struct configuration_t *config,
     }
     strncpy(options->editor, buffer, LINE_MAX - 1);
 
-    if (config_lookup_string(&cfg, "default_parser", &buffer)) {
-        if (!strncmp(buffer, "ag", 2))
-            options->search_type = AG_SEARCH;
-        else if (!strncmp(buffer, "git", 3))
-            options->search_type = GIT_SEARCH;
-        else
-            options->search_type = NGP_SEARCH;
+    /* commands of the built-in parsers */
+    if (config_lookup_string(&cfg, "ag_cmd", &buffer)) {
+        free(options->parsers[AG_SEARCH].command);
+        options->parsers[AG_SEARCH].command = strdup(buffer);
     }
 
-    if (config_lookup_string(&cfg, "ag_cmd", &buffer)) {
-        strncpy(options->parser_cmd[AG_SEARCH], buffer, LINE_MAX - 1);
-    } else {
-        fprintf(stderr, "ngprc: no ag_cmd string found!\n");
-        exit(-1);
+    if (config_lookup_string(&cfg, "git_cmd", &buffer) &&
+        strcmp(buffer, PREVIOUS_GIT_CMD)) {
+        free(options->parsers[GIT_SEARCH].command);
+        options->parsers[GIT_SEARCH].command = strdup(buffer);
     }
 
-    if (config_lookup_string(&cfg, "git_cmd", &buffer)) {
-        strncpy(options->parser_cmd[GIT_SEARCH], buffer, LINE_MAX - 1);
-    } else {
-        fprintf(stderr, "ngprc: no git_cmd string found!\n");
-        exit(-1);
+    if (config_lookup_string(&cfg, "rg_cmd", &buffer)) {
+        free(options->parsers[RG_SEARCH].command);
+        options->parsers[RG_SEARCH].command = strdup(buffer);
     }
 
+    read_parsers(&cfg, options);
+
+    if (config_lookup_string(&cfg, "default_parser", &buffer)) {
+        int index = find_parser(options, buffer);
+        options->search_type = index < 0 ? NGP_SEARCH : index;
+    }
+
+    int value;
+    if (config_lookup_int(&cfg, "max_line_length", &value) && value > 0)
+        options->max_line_length = value;
+
+    if (config_lookup_int(&cfg, "line_window", &value) && value > 0)
+        options->line_window = value;
+
+    if (config_lookup_int(&cfg, "result_memory_budget", &value) && value >= 0)
+        options->memory_budget = value;
+
+    if (config_lookup_int(&cfg, "threads", &value) && value >= 0)
+        options->threads = value;
+
+    if (config_lookup_int(&cfg, "frame_rate", &value) && value > 0)
+        options->frame_rate = value;
+
     if (config_lookup_string(&cfg, "files", &specific_files)) {
         options->specific_file = create_list();
         ptr = strtok_r((char *)specific_files, " ", &buf);
@@ -164,7 +275,7 @@ static void parse_ngp_search_args(struct options_t *options, int argc,
     int clear_extensions = 0;
     int clear_ignores = 0;
 
-    while ((opt = getopt(argc, argv, "eit:rI:")) != -1) {
+    while ((opt = getopt(argc, argv, "eit:rI:sl")) != -1) {
         switch (opt) {
             case 'i':
                 options->incase_option = 1;
@@ -192,6 +303,12 @@ static void parse_ngp_search_args(struct options_t *options, int argc,
             case 'e':
                 options->regexp_option = 1;
                 break;
+            case 's':
+                options->sort_option = 1;
+                break;
+            case 'l':
+                options->files_option = 1;
+                break;
             default:
                 free_options(options);
                 free(argv);
@@ -207,6 +324,12 @@ static void parse_args(struct options_t *options, int argc, char *argv[]) {
                                            {"nat", optional_argument, 0, 'n'},
                                            {"ag", optional_argument, 0, 'a'},
                                            {"git", optional_argument, 0, 'g'},
+                                           {"rg", optional_argument, 0, 'R'},
+                                           {"hybrid", optional_argument, 0,
+                                            'H'},
+                                           {"auto", optional_argument, 0, 'A'},
+                                           {"parser", required_argument, 0,
+                                            'P'},
                                            {0, 0, 0, 0}};
 
     int arg_count = argc;
@@ -272,6 +395,51 @@ static void parse_args(struct options_t *options, int argc, char *argv[]) {
 
                 argv[current_index] = NULL;
             } break;
+            case 'R': {
+                if (current_index != 1) goto error;
+
+                options->search_type = RG_SEARCH;
+
+                if (optarg != NULL) {
+                    strcpy(options->parser_options, optarg);
+                    opt = -1;
+                }
+
+                argv[current_index] = NULL;
+            } break;
+            case 'H': {
+                if (current_index != 1) goto error;
+
+                options->search_type = HYBRID_SEARCH;
+
+                if (optarg != NULL) {
+                    strcpy(options->parser_options, optarg);
+                    opt = -1;
+                }
+
+                argv[current_index] = NULL;
+            } break;
+            case 'A': {
+                if (current_index != 1) goto error;
+
+                options->search_type = AUTO_SEARCH;
+
+                if (optarg != NULL) {
+                    strcpy(options->parser_options, optarg);
+                    opt = -1;
+                }
+
+                argv[current_index] = NULL;
+            } break;
+            case 'P': {
+                if (current_index != 1) goto error;
+
+                int index = find_parser(options, optarg);
+                if (index < 0) goto error;
+
+                options->search_type = index;
+                argv[current_index] = NULL;
+            } break;
 
             case 1: {
                 if (current_index == 1) {
@@ -281,7 +449,7 @@ static void parse_args(struct options_t *options, int argc, char *argv[]) {
                 }
             }
             case '?': {
-                if (options->search_type == NGP_SEARCH) continue;
+                if (has_nat_options(options)) continue;
 
                 if (strlen(options->parser_options) > 0)
                     strcat(options->parser_options, " ");
@@ -291,7 +459,7 @@ static void parse_args(struct options_t *options, int argc, char *argv[]) {
         }
     }
 
-    if (options->search_type == NGP_SEARCH) {
+    if (has_nat_options(options)) {
 
         /* delete NULL pointer from args */
         arg_count = 0;
@@ -371,6 +539,19 @@ struct options_t *create_options(struct configuration_t *config, int argc,
     struct options_t *options = calloc(1, sizeof(*options));
 
     options->search_type = NGP_SEARCH;
+    options->max_line_length = DEFAULT_MAX_LINE_LENGTH;
+    options->line_window = DEFAULT_LINE_WINDOW;
+    options->memory_budget = DEFAULT_MEMORY_BUDGET;
+    options->frame_rate = DEFAULT_FRAME_RATE;
+    set_parser(&options->parsers[AG_SEARCH], "ag", DEFAULT_AG_CMD, "--ackmate",
+               get_format("ackmate"));
+    set_parser(&options->parsers[GIT_SEARCH], "git", DEFAULT_GIT_CMD,
+               "-z -n --column --color=always", get_format("null"));
+    set_parser(&options->parsers[RG_SEARCH], "rg", DEFAULT_RG_CMD, "--json",
+               get_format("json"));
+    options->parsers[HYBRID_SEARCH].name = strdup("hybrid");
+    options->parsers[AUTO_SEARCH].name = strdup("auto");
+    options->nbparser = NUM_SEARCHES;
     strcpy(options->directory, ".");
 
     read_config(config, options);
@@ -379,6 +560,16 @@ struct options_t *create_options(struct configuration_t *config, int argc,
     return options;
 }
 
+/* the compiled regexp belongs to the previous pattern */
+void set_pattern(struct options_t *options, const char *pattern) {
+    snprintf(options->pattern, sizeof(options->pattern), "%s", pattern);
+
+    if (options->pcre_compiled) pcre_free((void *)options->pcre_compiled);
+    if (options->pcre_extra) pcre_free((void *)options->pcre_extra);
+    options->pcre_compiled = NULL;
+    options->pcre_extra = NULL;
+}
+
 void free_options(struct options_t *options) {
     if (!options) {
         return;
@@ -401,5 +592,12 @@ void free_options(struct options_t *options) {
 
     if (options->pcre_extra) pcre_free((void *)options->pcre_extra);
 
+    int i;
+    for (i = 0; i < options->nbparser; i++) {
+        free(options->parsers[i].name);
+        free(options->parsers[i].command);
+        free(options->parsers[i].default_arguments);
+    }
+
     free(options);
 }
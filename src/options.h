@@ -20,6 +20,7 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #define OPTIONS_H
 
 #include "configuration.h"
+#include "parser.h"
 #include "search.h"
 
 #ifdef LINE_MAX
@@ -27,10 +28,27 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #endif
 #define LINE_MAX 512
 
+#define DEFAULT_MAX_LINE_LENGTH 1024
+#define DEFAULT_LINE_WINDOW 256
+#define DEFAULT_MEMORY_BUDGET 1024 /* in megabytes */
+#define DEFAULT_FRAME_RATE 30       /* frames per second */
+#define DEFAULT_AG_CMD "ag %1$s \"%2$s\" %3$s"
+/* git colors the matches only, whatever the theme of the user */
+#define DEFAULT_GIT_CMD                                                     \
+    "git -c color.grep.match=red -c color.grep.selected=normal "            \
+    "-c color.grep.context=normal -c color.grep.function=normal grep %1$s " \
+    "\"%2$s\" %3$s"
+/* git_cmd of the ngprc files written before */
+#define PREVIOUS_GIT_CMD "git grep %1$s \"%2$s\" %3$s"
+#define DEFAULT_RG_CMD "rg %1$s \"%2$s\" %3$s"
+
 typedef enum {
     NGP_SEARCH = 0,
     AG_SEARCH,
     GIT_SEARCH,
+    RG_SEARCH,
+    HYBRID_SEARCH, /* git grep for tracked files, nat for the others */
+    AUTO_SEARCH,   /* nat, hybrid or ag depending on the tree */
 
     NUM_SEARCHES
 } search_type_t;
@@ -46,17 +64,28 @@ struct options_t {
     struct list *ignore;
     int raw_option;
     int regexp_option;
+    int sort_option;
+    int files_option;
     int extension_option;
     int incase_option;
     int ignore_option;
     int regexp_is_ok;
+    int max_line_length;
+    int line_window;
+    int memory_budget;
+    int threads;
+    int frame_rate;
 
     search_type_t search_type;
-    char parser_cmd[NUM_SEARCHES][LINE_MAX];
+    /* indexed by search_type, parsers defined in ngprc come after the
+     * built-in ones */
+    external_parser_t parsers[MAX_PARSERS];
+    int nbparser;
     char parser_options[LINE_MAX];
 };
 
 struct options_t *create_options(struct configuration_t *config, int argc,
                                  char *argv[]);
+void set_pattern(struct options_t *options, const char *pattern);
 void free_options(struct options_t *options);
 #endif
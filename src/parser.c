@@ -0,0 +1,87 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "parser.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "file.h"
+#include "line.h"
+#include "search_utils.h"
+
+/* "<file>:<line>:<text>" or "<file>:<line>:<column>:<text>" records, as
+ * printed by grep -Hn or any tool mimicking it */
+static void parse_grep_record(struct result_t *result, char *output,
+                              size_t length, int has_column) {
+    char *end = output + length;
+    char *cursor;
+    range_t match = {0, 0};
+    int column = 0;
+
+    if (strcmp(output, "--") == 0) {
+        result->entries = create_blank_line(result);
+        return;
+    }
+
+    char *separator = memchr(output, ':', length);
+    if (!separator) return;
+
+    *separator = '\0';
+    int line_number = strtol(separator + 1, &cursor, 10);
+    if (line_number <= 0 || cursor >= end || *cursor != ':') return;
+
+    if (has_column) {
+        column = strtol(cursor + 1, &cursor, 10);
+        if (cursor >= end || *cursor != ':') return;
+    }
+
+    if (!is_current_file(result, output))
+        result->entries = create_file(result, output);
+
+    /* only the column of the match is known, cover what starts there */
+    if (has_column) match = get_column_match(result, cursor + 1, column);
+
+    result->entries = create_highlighted_line(result, cursor + 1, line_number,
+                                              &match, match.end > 0);
+}
+
+static void parse_grep_line(struct result_t *result, char *output,
+                            size_t length) {
+    parse_grep_record(result, output, length, 0);
+}
+
+static void parse_vimgrep_line(struct result_t *result, char *output,
+                               size_t length) {
+    parse_grep_record(result, output, length, 1);
+}
+
+static const struct format_t formats[] = {
+        {"ackmate", parse_ackmate_line}, {"null", parse_null_line},
+        {"json", parse_json_line},       {"grep", parse_grep_line},
+        {"vimgrep", parse_vimgrep_line},
+};
+
+const struct format_t *get_format(const char *name) {
+    size_t i;
+
+    for (i = 0; i < sizeof(formats) / sizeof(*formats); i++)
+        if (!strcmp(formats[i].name, name)) return &formats[i];
+
+    return NULL;
+}
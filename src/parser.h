@@ -0,0 +1,49 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <stddef.h>
+
+#define MAX_PARSERS 16
+
+struct result_t;
+
+/* decoder of one line of a backend output into result entries */
+struct format_t {
+    const char *name;
+    void (*parse_line)(struct result_t *result, char *output, size_t length);
+};
+
+/* backend run as command, a template where %1$s stands for the options,
+ * %2$s for the pattern and %3$s for the directory */
+typedef struct {
+    char *name;
+    char *command;
+    char *default_arguments;
+    const struct format_t *format;
+} external_parser_t;
+
+const struct format_t *get_format(const char *name);
+
+void parse_ackmate_line(struct result_t *result, char *output, size_t length);
+void parse_null_line(struct result_t *result, char *output, size_t length);
+void parse_json_line(struct result_t *result, char *output, size_t length);
+
+#endif
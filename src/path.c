@@ -0,0 +1,162 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "path.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_BUCKETS 256
+
+struct path_table_t *create_path_table() {
+    struct path_table_t *table = calloc(1, sizeof(*table));
+
+    table->nbbucket = INITIAL_BUCKETS;
+    table->buckets = malloc(table->nbbucket * sizeof(*table->buckets));
+    memset(table->buckets, 0xff, table->nbbucket * sizeof(*table->buckets));
+
+    return table;
+}
+
+static uint32_t hash_directory(int parent, const char *name, size_t length) {
+    uint32_t hash = 2166136261u ^ (uint32_t)parent;
+    size_t i;
+
+    for (i = 0; i < length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static void rehash(struct path_table_t *table) {
+    int i;
+
+    table->nbbucket *= 2;
+    table->buckets = realloc(table->buckets,
+                             table->nbbucket * sizeof(*table->buckets));
+    memset(table->buckets, 0xff, table->nbbucket * sizeof(*table->buckets));
+
+    for (i = 0; i < table->nbdirectory; i++) {
+        struct directory_t *directory = &table->directories[i];
+        int bucket = directory->hash & (table->nbbucket - 1);
+        directory->next = table->buckets[bucket];
+        table->buckets[bucket] = i;
+    }
+}
+
+static int intern_directory(struct path_table_t *table, int parent,
+                            const char *name, size_t length) {
+    uint32_t hash = hash_directory(parent, name, length);
+    int i = table->buckets[hash & (table->nbbucket - 1)];
+
+    for (; i != NO_DIRECTORY; i = table->directories[i].next) {
+        struct directory_t *directory = &table->directories[i];
+        if (directory->hash == hash && directory->parent == parent &&
+            strncmp(directory->name, name, length) == 0 &&
+            directory->name[length] == '\0')
+            return i;
+    }
+
+    if (table->nbdirectory == table->directories_size) {
+        table->directories_size =
+                table->directories_size ? table->directories_size * 2 : 64;
+        table->directories =
+                realloc(table->directories,
+                        table->directories_size * sizeof(*table->directories));
+    }
+
+    if (table->nbdirectory >= table->nbbucket) rehash(table);
+
+    int id = table->nbdirectory++;
+    int bucket = hash & (table->nbbucket - 1);
+    struct directory_t *directory = &table->directories[id];
+
+    directory->parent = parent;
+    directory->hash = hash;
+    directory->name = strndup(name, length);
+    directory->next = table->buckets[bucket];
+    table->buckets[bucket] = id;
+
+    return id;
+}
+
+int intern_path(struct path_table_t *table, const char *path,
+                const char **basename) {
+    int directory = NO_DIRECTORY;
+    const char *component = path;
+    const char *slash;
+
+    /* an absolute path hangs below a root node with an empty name */
+    if (*component == '/') directory = intern_directory(table, directory, "", 0);
+
+    while ((slash = strchr(component, '/')) != NULL) {
+        size_t length = slash - component;
+
+        /* skip empty components and leading "./" */
+        if (length > 0 && !(length == 1 && *component == '.' &&
+                            directory == NO_DIRECTORY))
+            directory = intern_directory(table, directory, component, length);
+
+        component = slash + 1;
+    }
+
+    *basename = component;
+    return directory;
+}
+
+int get_parent_directory(struct path_table_t *table, int directory) {
+    if (directory == NO_DIRECTORY) return NO_DIRECTORY;
+
+    return table->directories[directory].parent;
+}
+
+static size_t append_directory(struct path_table_t *table, int directory,
+                               char *buffer, size_t size) {
+    if (directory == NO_DIRECTORY) return 0;
+
+    struct directory_t *node = &table->directories[directory];
+    size_t length = append_directory(table, node->parent, buffer, size);
+
+    if (length < size)
+        length += snprintf(buffer + length, size - length, "%s/", node->name);
+
+    return length;
+}
+
+char *build_path(struct path_table_t *table, int directory,
+                 const char *basename, char *buffer, size_t size) {
+    size_t length = append_directory(table, directory, buffer, size);
+
+    if (length < size) snprintf(buffer + length, size - length, "%s", basename);
+
+    return buffer;
+}
+
+void free_path_table(struct path_table_t *table) {
+    int i;
+
+    for (i = 0; i < table->nbdirectory; i++)
+        free(table->directories[i].name);
+
+    free(table->directories);
+    free(table->buckets);
+    free(table);
+}
@@ -0,0 +1,53 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PATH_H
+#define PATH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* directories are interned once as (parent, name) nodes so that files
+ * only need to keep their basename and the id of their directory */
+struct directory_t {
+    int parent;
+    int next; /* next node in the same hash bucket */
+    uint32_t hash;
+    char *name;
+};
+
+struct path_table_t {
+    struct directory_t *directories;
+    int nbdirectory;
+    int directories_size;
+
+    int *buckets;
+    int nbbucket;
+};
+
+#define NO_DIRECTORY -1
+
+struct path_table_t *create_path_table();
+int intern_path(struct path_table_t *table, const char *path,
+                const char **basename);
+int get_parent_directory(struct path_table_t *table, int directory);
+char *build_path(struct path_table_t *table, int directory,
+                 const char *basename, char *buffer, size_t size);
+void free_path_table(struct path_table_t *table);
+
+#endif
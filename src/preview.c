@@ -0,0 +1,154 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "preview.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct preview_t *create_preview() {
+    return calloc(1, sizeof(struct preview_t));
+}
+
+static void unmap_file(struct mapped_file_t *file) {
+    if (file->data) munmap(file->data, file->size);
+    free(file->lines);
+
+    file->path[0] = '\0';
+    file->data = NULL;
+    file->size = 0;
+    file->lines = NULL;
+    file->nbline = 0;
+    file->used = 0;
+}
+
+/* the lines are found once, looking one up is then constant time */
+static void index_lines(struct mapped_file_t *file) {
+    const char *pointer = file->data;
+    const char *end = file->data + file->size;
+    int size = 1024;
+
+    file->lines = malloc(size * sizeof(*file->lines));
+    file->lines[0] = 0;
+    file->nbline = 0;
+
+    while (pointer < end) {
+        const char *endline = memchr(pointer, '\n', end - pointer);
+        pointer = endline ? endline + 1 : end;
+
+        if (file->nbline + 2 > size) {
+            size *= 2;
+            file->lines = realloc(file->lines, size * sizeof(*file->lines));
+        }
+        file->lines[++file->nbline] = pointer - file->data;
+    }
+}
+
+static int map_file(struct mapped_file_t *file, const char *path) {
+    struct stat sb;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) return 0;
+
+    if (fstat(fd, &sb) < 0 || !S_ISREG(sb.st_mode)) {
+        close(fd);
+        return 0;
+    }
+
+    /* an empty file cannot be mapped */
+    if (sb.st_size > 0) {
+        file->data = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (file->data == MAP_FAILED) {
+            file->data = NULL;
+            close(fd);
+            return 0;
+        }
+    }
+
+    close(fd);
+
+    file->size = sb.st_size;
+    snprintf(file->path, sizeof(file->path), "%s", path);
+    index_lines(file);
+
+    return 1;
+}
+
+/* path mapped, in place of the least recently used file once PREVIEW_FILES
+ * are, NULL if it cannot be read */
+struct mapped_file_t *get_mapped_file(struct preview_t *preview,
+                                      const char *path) {
+    struct mapped_file_t *file = NULL;
+    int i;
+
+    for (i = 0; i < preview->nbfile; i++) {
+        if (!strcmp(preview->files[i].path, path)) {
+            file = &preview->files[i];
+            break;
+        }
+    }
+
+    if (!file) {
+        if (preview->nbfile < PREVIEW_FILES) {
+            file = &preview->files[preview->nbfile++];
+        } else {
+            file = &preview->files[0];
+            for (i = 1; i < preview->nbfile; i++)
+                if (preview->files[i].used < file->used)
+                    file = &preview->files[i];
+            unmap_file(file);
+        }
+
+        if (!map_file(file, path)) return NULL;
+    }
+
+    file->used = ++preview->clock;
+    return file;
+}
+
+/* line, from 1, without its end of line, NULL past the end of file */
+const char *get_mapped_line(struct mapped_file_t *file, int line,
+                            size_t *length) {
+    if (line < 1 || line > file->nbline) return NULL;
+
+    const char *begin = file->data + file->lines[line - 1];
+    *length = file->lines[line] - file->lines[line - 1];
+    if (*length > 0 && begin[*length - 1] == '\n') (*length)--;
+
+    return begin;
+}
+
+/* files may have changed, once opened in the editor for instance */
+void clear_preview(struct preview_t *preview) {
+    int i;
+
+    for (i = 0; i < preview->nbfile; i++) unmap_file(&preview->files[i]);
+    preview->nbfile = 0;
+}
+
+void free_preview(struct preview_t *preview) {
+    if (!preview) return;
+
+    clear_preview(preview);
+    free(preview);
+}
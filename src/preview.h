@@ -0,0 +1,54 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PREVIEW_H
+#define PREVIEW_H
+
+#include <limits.h>
+#include <stddef.h>
+
+/* files kept mapped by the preview */
+#define PREVIEW_FILES 16
+
+/* a file mapped once and the offset of each of its lines */
+struct mapped_file_t {
+    char path[PATH_MAX];
+    char *data;
+    size_t size;
+    /* lines[i] is where line i + 1 begins, lines[nbline] the end of file */
+    size_t *lines;
+    int nbline;
+    /* when it was looked at last, for the least recently used to go */
+    unsigned long used;
+};
+
+struct preview_t {
+    struct mapped_file_t files[PREVIEW_FILES];
+    int nbfile;
+    unsigned long clock;
+};
+
+struct preview_t *create_preview();
+struct mapped_file_t *get_mapped_file(struct preview_t *preview,
+                                      const char *path);
+const char *get_mapped_line(struct mapped_file_t *file, int line,
+                            size_t *length);
+void clear_preview(struct preview_t *preview);
+void free_preview(struct preview_t *preview);
+
+#endif
@@ -0,0 +1,240 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "result.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "entry.h"
+#include "file.h"
+#include "line.h"
+#include "path.h"
+#include "utils.h"
+
+struct result_t *create_result() {
+    struct result_t *result = calloc(1, sizeof(*result));
+    result->entries = NULL;
+    result->start = result->entries;
+    result->nbentry = 0;
+    result->paths = create_path_table();
+    result->spill_fd = -1;
+
+    return result;
+}
+
+static int open_spill_file() {
+    char path[PATH_MAX];
+    const char *directory = getenv("TMPDIR");
+
+    snprintf(path, sizeof(path), "%s/ngp-XXXXXX", directory ? directory : "/tmp");
+
+    int fd = mkstemp(path);
+    if (fd >= 0) unlink(path);
+
+    return fd;
+}
+
+/* a full spilled chunk is dropped from memory, the kernel pages it back in
+ * from the spill file whenever the display reaches its entries again */
+static void release_chunk(struct chunk_t *chunk) {
+    if (!chunk || !chunk->spilled) return;
+
+    msync(chunk->memory, chunk->size, MS_ASYNC);
+    madvise(chunk->memory, chunk->size, MADV_DONTNEED);
+}
+
+static int spill_chunk(struct result_t *result, struct chunk_t *chunk) {
+    if (result->spill_fd < 0) result->spill_fd = open_spill_file();
+    if (result->spill_fd < 0) return 0;
+
+    if (ftruncate(result->spill_fd, result->spill_size + chunk->size) < 0)
+        return 0;
+
+    chunk->memory = mmap(NULL, chunk->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         result->spill_fd, result->spill_size);
+    if (chunk->memory == MAP_FAILED) return 0;
+
+    result->spill_size += chunk->size;
+    chunk->spilled = 1;
+
+    return 1;
+}
+
+static struct chunk_t *create_chunk(struct result_t *result, size_t size) {
+    struct chunk_t *chunk = calloc(1, sizeof(*chunk));
+    long page_size = sysconf(_SC_PAGESIZE);
+
+    chunk->size = (size + page_size - 1) / page_size * page_size;
+
+    if (!result->memory_budget ||
+        result->memory_used + chunk->size <= result->memory_budget ||
+        !spill_chunk(result, chunk)) {
+        chunk->memory = calloc(1, chunk->size);
+        result->memory_used += chunk->size;
+    }
+
+    release_chunk(result->chunks);
+    chunk->next = result->chunks;
+    result->chunks = chunk;
+
+    return chunk;
+}
+
+void *alloc_entry(struct result_t *result, size_t size) {
+    struct chunk_t *chunk = result->chunks;
+
+    /* keep entries pointer aligned */
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+    if (!chunk || chunk->used + size > chunk->size)
+        chunk = create_chunk(result, size > CHUNK_SIZE ? size : CHUNK_SIZE);
+
+    void *entry = chunk->memory + chunk->used;
+    chunk->used += size;
+
+    return entry;
+}
+
+void add_entry(struct result_t *result, struct entry_t *entry) {
+    int position = result->nbentry;
+
+    if (position == 0) clock_gettime(CLOCK_MONOTONIC, &result->first_entry);
+
+    if (result->entries) {
+        result->entries->next = entry;
+    } else {
+        result->start = entry;
+    }
+
+    if (position % CHECKPOINT_INTERVAL == 0) {
+        int checkpoint = position / CHECKPOINT_INTERVAL;
+        result->checkpoints =
+                grow_array(result->checkpoints, &result->checkpoints_size,
+                           checkpoint + 1, sizeof(*result->checkpoints));
+        result->checkpoints[checkpoint] = entry;
+    }
+
+    if (entry->type == FILE_ENTRY) {
+        result->files = grow_array(result->files, &result->files_size,
+                                   result->nbfile + 1, sizeof(*result->files));
+        result->file_positions = grow_array(
+                result->file_positions, &result->file_positions_size,
+                result->nbfile + 1, sizeof(*result->file_positions));
+        result->file_positions[result->nbfile] = position;
+        result->files[result->nbfile++] = get_type(entry, FILE_ENTRY);
+    }
+
+    if (entry->is_selectable) {
+        struct line_t *line = get_type(entry, LINE_ENTRY);
+        struct file_t *file = line ? get_file(result, line->file) : NULL;
+        if (file) file->count++;
+
+        result->selectable =
+                grow_array(result->selectable, &result->selectable_size,
+                           result->nbselectable + 1,
+                           sizeof(*result->selectable));
+        result->selectable[result->nbselectable++] = position;
+    }
+
+    result->nbentry++;
+}
+
+struct entry_t *get_entry(struct result_t *result, int index) {
+    if (index < 0 || index >= result->nbentry) return NULL;
+
+    struct entry_t *ptr = result->checkpoints[index / CHECKPOINT_INTERVAL];
+    int i;
+    for (i = 0; i < index % CHECKPOINT_INTERVAL; i++) ptr = ptr->next;
+
+    return ptr;
+}
+
+struct file_t *get_file(struct result_t *result, int id) {
+    if (id < 0 || id >= result->nbfile) return NULL;
+
+    return result->files[id];
+}
+
+int next_selectable(struct result_t *result, int index) {
+    int i = lower_bound(result->selectable, result->nbselectable, index);
+    if (i == result->nbselectable) return -1;
+
+    return result->selectable[i];
+}
+
+int previous_selectable(struct result_t *result, int index) {
+    int i = lower_bound(result->selectable, result->nbselectable, index + 1);
+    if (i == 0) return -1;
+
+    return result->selectable[i - 1];
+}
+
+/* position of the first file entry after index, -1 if there is none */
+int next_file(struct result_t *result, int index) {
+    int i = lower_bound(result->file_positions, result->nbfile, index + 1);
+    if (i == result->nbfile) return -1;
+
+    return result->file_positions[i];
+}
+
+/* position of the last file entry before index, -1 if there is none */
+int previous_file(struct result_t *result, int index) {
+    int i = lower_bound(result->file_positions, result->nbfile, index);
+    if (i == 0) return -1;
+
+    return result->file_positions[i - 1];
+}
+
+/* whether the lines of file were added, or only counted */
+int has_file_lines(struct result_t *result, int file) {
+    struct entry_t *entry =
+            get_entry(result, result->file_positions[file] + 1);
+
+    return entry && entry->type == LINE_ENTRY;
+}
+
+void free_result(struct result_t *result) {
+    struct chunk_t *chunk = result->chunks;
+
+    while (chunk) {
+        struct chunk_t *next = chunk->next;
+
+        if (chunk->spilled)
+            munmap(chunk->memory, chunk->size);
+        else
+            free(chunk->memory);
+
+        free(chunk);
+        chunk = next;
+    }
+
+    if (result->spill_fd >= 0) close(result->spill_fd);
+
+    free_path_table(result->paths);
+    free(result->pattern);
+    free(result->files);
+    free(result->file_positions);
+    free(result->selectable);
+    free(result->checkpoints);
+    free(result);
+}
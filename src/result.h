@@ -0,0 +1,97 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RESULT_H
+#define RESULT_H
+
+#include <stddef.h>
+#include <time.h>
+
+/* one out of CHECKPOINT_INTERVAL entries is directly addressable */
+#define CHECKPOINT_INTERVAL 64
+
+/* entries are carved out of chunks of CHUNK_SIZE bytes */
+#define CHUNK_SIZE (1 << 20)
+
+struct chunk_t {
+    struct chunk_t *next;
+    char *memory;
+    size_t size;
+    size_t used;
+    int spilled;
+};
+
+struct result_t {
+    struct entry_t *entries;
+    struct entry_t *start;
+    int nbentry;
+
+    /* monotonic time at which the first entry was added */
+    struct timespec first_entry;
+
+    /* lines longer than max_line_length only keep line_window
+     * characters around their match */
+    int max_line_length;
+    int line_window;
+
+    /* pattern searched, to find where matches end for backends that only
+     * tell where they begin */
+    char *pattern;
+    int incase;
+
+    /* sorted positions of the selectable entries */
+    int *selectable;
+    int nbselectable;
+    int selectable_size;
+
+    /* directories shared by the file entries */
+    struct path_table_t *paths;
+
+    /* file entries, in the order they were added, and their positions */
+    struct file_t **files;
+    int nbfile;
+    int files_size;
+    int *file_positions;
+    int file_positions_size;
+
+    /* every CHECKPOINT_INTERVAL-th entry */
+    struct entry_t **checkpoints;
+    int checkpoints_size;
+
+    /* once chunks use more than memory_budget bytes (0 for no limit), new
+     * chunks are mapped from a temporary spill file */
+    struct chunk_t *chunks;
+    size_t memory_budget;
+    size_t memory_used;
+    int spill_fd;
+    size_t spill_size;
+};
+
+struct result_t *create_result();
+void *alloc_entry(struct result_t *result, size_t size);
+void add_entry(struct result_t *result, struct entry_t *entry);
+struct entry_t *get_entry(struct result_t *result, int index);
+struct file_t *get_file(struct result_t *result, int id);
+int next_selectable(struct result_t *result, int index);
+int previous_selectable(struct result_t *result, int index);
+int next_file(struct result_t *result, int index);
+int has_file_lines(struct result_t *result, int file);
+int previous_file(struct result_t *result, int index);
+void free_result(struct result_t *result);
+
+#endif
@@ -0,0 +1,143 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "parser.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "entry.h"
+#include "file.h"
+#include "json.h"
+#include "line.h"
+#include "search_utils.h"
+
+/*
+ * command: rg --json -C 1 "rg_"
+ *
+ *{"type":"begin","data":{"path":{"text":"src/search.c"}}}
+ *{"type":"context","data":{"path":{"text":"src/search.c"},"lines":{"text":
+ *  "void do_git_search(struct search_t *search);\n"},"line_number":29,
+ *  "absolute_offset":711,"submatches":[]}}
+ *{"type":"match","data":{"path":{"text":"src/search.c"},"lines":{"text":
+ *  "void do_rg_search(struct search_t *search);\n"},"line_number":30,
+ *  "absolute_offset":757,"submatches":[{"match":{"text":"rg_"},"start":8,
+ *  "end":11}]}}
+ *{"type":"end","data":{"path":{"text":"src/search.c"},"binary_offset":null,
+ *  "stats":{...}}}
+ *{"type":"summary","data":{...}}
+ *
+ * every line is a single event, read as a stream of values without
+ * building any tree. Paths or lines that are not valid UTF-8 come as
+ * base64 "bytes" instead of "text" and are skipped.
+ */
+
+struct rg_event_t {
+    const char *type;
+    char *path;
+    char *text;
+    size_t length;
+    int line_number;
+    range_t matches[MAX_HIGHLIGHTS];
+    int nbmatch;
+};
+
+static int is_key(const char **keys, int depth, const char *first,
+                  const char *second, const char *third) {
+    const char *expected[] = {"data", first, second, third};
+    int i;
+
+    for (i = 0; i < depth; i++) {
+        if (i == 4 || !expected[i]) return 0;
+        if (!keys[i] || strcmp(keys[i], expected[i])) return 0;
+    }
+
+    return i == 4 || !expected[i];
+}
+
+static void read_event(void *data, const char **keys, int depth,
+                       struct json_value_t *value) {
+    struct rg_event_t *event = data;
+
+    if (depth == 1 && !strcmp(keys[0], "type")) {
+        event->type = value->text;
+    } else if (is_key(keys, depth, "path", "text", NULL)) {
+        event->path = value->text;
+    } else if (is_key(keys, depth, "lines", "text", NULL)) {
+        event->text = value->text;
+        event->length = value->length;
+    } else if (is_key(keys, depth, "line_number", NULL, NULL)) {
+        event->line_number = atoi(value->text);
+    } else if (depth == 4 && !strcmp(keys[0], "data") &&
+               !strcmp(keys[1], "submatches") && keys[3]) {
+        /* submatches are byte offsets into the line, "start" comes first */
+        if (!strcmp(keys[3], "start") && event->nbmatch < MAX_HIGHLIGHTS) {
+            event->matches[event->nbmatch].begin = atoi(value->text);
+        } else if (!strcmp(keys[3], "end") &&
+                   event->nbmatch < MAX_HIGHLIGHTS) {
+            event->matches[event->nbmatch++].end = atoi(value->text);
+        }
+    }
+}
+
+/* rg has no separator between context groups, add one whenever a context
+ * line is not adjacent to the previous line */
+static void separate_context(struct result_t *result, int line_number,
+                             int is_context) {
+    struct line_t *previous = get_type(result->entries, LINE_ENTRY);
+
+    if (!previous || previous->line == 0) return;
+    if (previous->line + 1 == line_number) return;
+    if (!is_context && previous->entry.is_selectable) return;
+
+    result->entries = create_blank_line(result);
+}
+
+void parse_json_line(struct result_t *result, char *output, size_t length) {
+    struct rg_event_t event = {NULL};
+
+    if (!parse_json(output, length, read_event, &event) || !event.type) return;
+
+    if (!strcmp(event.type, "begin")) {
+        if (event.path) result->entries = create_file(result, event.path);
+        return;
+    }
+
+    int is_match = !strcmp(event.type, "match");
+    if (!is_match && strcmp(event.type, "context")) return;
+
+    if (!event.text || event.line_number <= 0) return;
+
+    /* the path of the file was not valid UTF-8 on begin */
+    if (!event.path || !is_current_file(result, event.path)) return;
+
+    while (event.length > 0 && (event.text[event.length - 1] == '\n' ||
+                                event.text[event.length - 1] == '\r'))
+        event.text[--event.length] = '\0';
+
+    separate_context(result, event.line_number, !is_match);
+
+    if (is_match) {
+        result->entries = create_highlighted_line(
+                result, event.text, event.line_number, event.matches,
+                event.nbmatch);
+    } else {
+        result->entries = create_unselectable_line(result, event.text,
+                                                   event.line_number);
+    }
+}
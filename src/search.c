@@ -19,24 +19,34 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #include "search.h"
 
 #include <string.h>
+#include <unistd.h>
 
 #include "entry.h"
 #include "list.h"
 #include "options.h"
+#include "search_utils.h"
+
+/* bumped to stop every search created before */
+static int current_generation;
 
 void do_ngp_search(struct search_t *search);
-void do_ag_search(struct search_t *search);
-void do_git_search(struct search_t *search);
+void do_hybrid_search(struct search_t *search);
+void do_auto_search(struct search_t *search);
 
 struct search_t *create_search(struct options_t *options) {
-    struct result_t *result = calloc(1, sizeof(*result));
-    result->entries = NULL;
-    result->start = result->entries;
-    result->nbentry = 0;
+    struct result_t *result = create_result();
+    result->max_line_length = options->max_line_length;
+    result->line_window = options->line_window;
+    result->pattern = strdup(options->pattern);
+    result->incase = options->incase_option;
+    result->memory_budget = (size_t)options->memory_budget << 20;
 
     struct search_t *search = calloc(1, sizeof(*search));
     search->result = result;
     search->status = 1;
+    search->type = options->search_type;
+    search->wakeup_fd = -1;
+    search->generation = __atomic_load_n(&current_generation, __ATOMIC_ACQUIRE);
 
     search->options = options;
 
@@ -44,33 +54,44 @@ struct search_t *create_search(struct options_t *options) {
 }
 
 void do_search(struct search_t *search) {
-    switch (search->options->search_type) {
-        case NGP_SEARCH:
-            return do_ngp_search(search);
+    struct options_t *options = search->options;
 
-        case AG_SEARCH:
-            return do_ag_search(search);
+    if (search->type == NGP_SEARCH) return do_ngp_search(search);
 
-        case GIT_SEARCH:
-            return do_git_search(search);
+    if (search->type == HYBRID_SEARCH) return do_hybrid_search(search);
 
-        default:
-            break;
-    }
+    if (search->type == AUTO_SEARCH) return do_auto_search(search);
+
+    spawn_search(search, &options->parsers[search->type],
+                 options->parser_options);
+}
+
+/* called with data_mutex held: a single wake up is pending until the
+ * interface has drawn the results */
+void notify_search(struct search_t *search) {
+    if (search->wakeup_fd < 0 || search->notified) return;
+
+    search->notified = 1;
+    if (write(search->wakeup_fd, "", 1) < 0) search->notified = 0;
+}
+
+void cancel_searches() {
+    __atomic_add_fetch(&current_generation, 1, __ATOMIC_RELEASE);
+}
 
-    exit(-1);
+/* checked by the native search for every file */
+int is_search_stale(struct search_t *search) {
+    return search->generation !=
+           __atomic_load_n(&current_generation, __ATOMIC_ACQUIRE);
 }
 
 void free_search(struct search_t *search) {
-    struct entry_t *ptr = search->result->start;
-    struct entry_t *p;
+    free_result(search->result);
 
-    while (ptr) {
-        p = ptr;
-        ptr = ptr->next;
-        free_entry(p);
+    if (search->listing) {
+        free(search->listing->paths);
+        free(search->listing);
     }
-    free(search->result);
 
     if (search->options) {
         free_options(search->options);
@@ -24,11 +24,15 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #include <pthread.h>
 
 #include "options.h"
+#include "result.h"
 
-struct result_t {
-    struct entry_t *entries;
-    struct entry_t *start;
-    int nbentry;
+/* wanted files found by a native search walking the directory, the next
+ * searches submit them without walking it again */
+struct listing_t {
+    char *paths; /* '\0' separated */
+    size_t size;
+    size_t used;
+    int complete;
 };
 
 struct search_t {
@@ -39,11 +43,30 @@ struct search_t {
     pthread_mutex_t data_mutex;
     int status;
 
+    /* why the search failed, read once it is over */
+    char error[PATH_MAX];
+
+    /* written to when results are published, -1 when nobody waits */
+    int wakeup_fd;
+    int notified;
+
+    /* backend run, an auto search picks one without touching options */
+    int type;
+    /* hybrid searches read the ignored and binary files too, as nat does */
+    int every_file;
+
+    /* generation the search was created in, it stops once stale */
+    int generation;
+    struct listing_t *listing;
+
     struct options_t *options;
 };
 
 struct search_t *create_search(struct options_t *options);
 void do_search(struct search_t *search);
+void notify_search(struct search_t *search);
+void cancel_searches();
+int is_search_stale(struct search_t *search);
 void free_search(struct search_t *search);
 
 #endif
@@ -16,80 +16,328 @@ You should have received a copy of the GNU General Public License
 along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#define _GNU_SOURCE
+
 #include "search_utils.h"
 
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/stat.h>
+#include <strings.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
+#include "file.h"
 #include "utils.h"
 
-void resize_string(char **string, size_t *string_size, size_t minimal_size) {
-    size_t str_len = strlen(*string);
-    size_t new_size = *string_size;
-    while (minimal_size >= new_size - str_len) {
-        new_size *= 2;
+int is_current_file(struct result_t *result, const char *path) {
+    char current[PATH_MAX];
+    struct file_t *file;
+
+    if (result->nbfile == 0) return 0;
+
+    /* most lines belong to the current file, compare basenames first */
+    file = get_file(result, result->nbfile - 1);
+    const char *basename = strrchr(path, '/');
+    if (strcmp(basename ? basename + 1 : path, file->entry.data)) return 0;
+
+    /* paths are interned without their leading "./" */
+    while (path[0] == '.' && path[1] == '/') path += 2;
+
+    get_file_path(result, file, current, sizeof(current));
+    return strcmp(current, path) == 0;
+}
+
+static int is_word_character(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+/* the match beginning at column, from 1, of text: the pattern when it is
+ * found there, the word there otherwise, and a single character at least */
+range_t get_column_match(struct result_t *result, const char *text,
+                         int column) {
+    size_t length = strlen(text);
+    size_t pattern_length = result->pattern ? strlen(result->pattern) : 0;
+    range_t match = {0, 0};
+
+    if (column < 1 || column > length) return match;
+
+    match.begin = match.end = column - 1;
+
+    if (pattern_length && match.begin + pattern_length <= length) {
+        const char *at = text + match.begin;
+        int found = result->incase
+                            ? !strncasecmp(at, result->pattern, pattern_length)
+                            : !strncmp(at, result->pattern, pattern_length);
+
+        if (found) {
+            match.end += pattern_length;
+            return match;
+        }
     }
 
-    if (new_size != *string_size) {
-        *string = realloc(*string, new_size);
-        *string_size = new_size;
+    while (match.end < length && is_word_character(text[match.end]))
+        match.end++;
+    if (match.end == match.begin) match.end++;
+
+    return match;
+}
+
+/* splits string into words the way a shell would for simple commands:
+ * blanks separate words, quotes group them and backslash escapes a character
+ */
+static int split_words(const char *string, char **words, int max) {
+    int nbword = 0;
+
+    while (*string) {
+        while (*string == ' ' || *string == '\t') string++;
+        if (!*string) break;
+
+        char *word = malloc(strlen(string) + 1);
+        char *write = word;
+        char quote = '\0';
+
+        for (; *string; string++) {
+            if (quote) {
+                if (*string == quote)
+                    quote = '\0';
+                else if (quote == '"' && *string == '\\' && string[1])
+                    *write++ = *++string;
+                else
+                    *write++ = *string;
+            } else if (*string == '\'' || *string == '"') {
+                quote = *string;
+            } else if (*string == '\\' && string[1]) {
+                *write++ = *++string;
+            } else if (*string == ' ' || *string == '\t') {
+                break;
+            } else {
+                *write++ = *string;
+            }
+        }
+        *write = '\0';
+
+        if (nbword == max) {
+            free(word);
+            break;
+        }
+        words[nbword++] = word;
     }
+
+    return nbword;
 }
 
-int validate_file(const char *path) {
-    struct stat st;
+/* replaces the %1$s, %2$s and %3$s arguments of a command word */
+static char *expand_word(const char *word, const char **arguments) {
+    size_t length = strlen(word) + 1;
+    const char *read;
+    int i;
+
+    for (i = 0; i < 3; i++) length += strlen(arguments[i]);
+    for (read = word; (read = strchr(read, '%')); read++)
+        length += strlen(arguments[0]) + strlen(arguments[1]) +
+                  strlen(arguments[2]);
 
-    if (stat(path, &st) == 0 && S_ISREG(st.st_mode) == 1) return 1;
+    char *expanded = malloc(length);
+    char *write = expanded;
+
+    for (read = word; *read; read++) {
+        if (read[0] == '%' && read[1] >= '1' && read[1] <= '3' &&
+            !strncmp(read + 2, "$s", 2)) {
+            const char *argument = arguments[read[1] - '1'];
+            strcpy(write, argument);
+            write += strlen(argument);
+            read += 3;
+        } else {
+            *write++ = *read;
+        }
+    }
+    *write = '\0';
 
-    return 0;
+    return expanded;
 }
 
-const char *apply_regex(const char *output, const char *expr) {
-    struct options_t *options = calloc(1, sizeof(*options));
-    char *match = regex(options, output, expr);
-    free(options);
-    return match;
+/* builds the argument vector of a backend from its ngprc template: the
+ * options word expands to as many arguments as there are options while the
+ * pattern and the directory always stay a single argument */
+int build_argv(const char *command, const char *options, const char *pattern,
+               const char *directory, char **argv) {
+    char *words[MAX_ARGUMENTS];
+    const char *arguments[] = {options, pattern, directory};
+    int nbword, argc = 0;
+    int i;
+
+    nbword = split_words(command, words, MAX_ARGUMENTS);
+
+    for (i = 0; i < nbword; i++) {
+        if (!strcmp(words[i], "%1$s"))
+            argc += split_words(options, argv + argc, MAX_ARGUMENTS - argc - 1);
+        else if (argc < MAX_ARGUMENTS - 1)
+            argv[argc++] = expand_word(words[i], arguments);
+
+        free(words[i]);
+    }
+    argv[argc] = NULL;
+
+    return argc;
 }
 
-void popen_search(struct search_t *search, external_parser_t *parser) {
-    char parser_args[PATH_MAX] = "";
-    strcat(parser_args, parser->default_arguments);
-    strcat(parser_args, search->options->parser_options);
-
-    char command[PATH_MAX] = "";
-    snprintf(command, sizeof(command),
-             search->options->parser_cmd[search->options->search_type],
-             parser_args, search->options->pattern, search->options->directory);
-
-    /* open the command for reading. */
-    FILE *fp = popen(command, "r");
-    if (fp == NULL) {
-        printf("Failed to run command: %s \n", command);
-        exit(1);
+void free_argv(char **argv) {
+    int i;
+
+    for (i = 0; argv[i]; i++) free(argv[i]);
+}
+
+static pid_t spawn_child(char **argv, int *fd) {
+    posix_spawn_file_actions_t actions;
+    int fds[2];
+    pid_t pid;
+
+    if (pipe2(fds, O_CLOEXEC) < 0) return -1;
+
+#ifdef F_SETPIPE_SZ
+    /* fewer wake ups for a fast backend, best effort only */
+    fcntl(fds[1], F_SETPIPE_SZ, PIPE_SIZE);
+#endif
+
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+
+    int error = posix_spawnp(&pid, argv[0], &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+
+    if (error) {
+        close(fds[0]);
+        return -1;
+    }
+
+    *fd = fds[0];
+    return pid;
+}
+
+/* hands every complete record of buffer to the callback, returns the length
+ * of the incomplete record left at its end */
+static size_t parse_records(char *buffer, size_t size, char separator,
+                            pthread_mutex_t *mutex, record_callback_t callback,
+                            void *data) {
+    char *record = buffer;
+    char *end = buffer + size;
+    char *eor;
+
+    if (mutex) pthread_mutex_lock(mutex);
+
+    while ((eor = memchr(record, separator, end - record))) {
+        *eor = '\0';
+        callback(data, record, eor - record);
+        record = eor + 1;
+    }
+
+    if (mutex) pthread_mutex_unlock(mutex);
+
+    memmove(buffer, record, end - record);
+    return end - record;
+}
+
+int run_command(char **argv, char separator, struct search_t *search,
+                pthread_mutex_t *mutex, record_callback_t callback,
+                void *data) {
+    size_t capacity = READ_BLOCK_SIZE;
+    size_t size = 0;
+    ssize_t nbread;
+    int status = -1;
+    int fd;
+
+    pid_t pid = spawn_child(argv, &fd);
+    if (pid < 0) return -1;
+
+    /* the output is read by large blocks and split into records in place */
+    char *buffer = malloc(capacity + 1);
+    struct pollfd output = {fd, POLLIN, 0};
+
+    while (1) {
+        /* a stale search kills its backend, however quiet it is */
+        if (search && is_search_stale(search)) {
+            kill(pid, SIGTERM);
+            size = 0;
+            break;
+        }
+
+        /* on EINTR too, the next read could block past the cancellation */
+        if (poll(&output, 1, search ? CANCEL_INTERVAL : -1) <= 0) continue;
+
+        nbread = read(fd, buffer + size, capacity - size);
+        if (nbread == 0) break;
+        if (nbread < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            break;
+        }
+
+        size = parse_records(buffer, size + nbread, separator, mutex, callback,
+                             data);
+
+        /* a single record fills the whole buffer */
+        if (size == capacity) {
+            capacity *= 2;
+            buffer = realloc(buffer, capacity + 1);
+        }
     }
 
-    /* parse the output a line at a time. */
-    size_t read_size;
-    char *line;
-    while (getline(&line, &read_size, fp) != -1) {
+    /* last record without a trailing separator */
+    if (size > 0) {
+        buffer[size++] = separator;
+        parse_records(buffer, size, separator, mutex, callback, data);
+    }
+
+    close(fd);
+    waitpid(pid, &status, 0);
+    free(buffer);
+
+    return status;
+}
 
-        char *eol = &line[strlen(line) - 1];
-        if (*eol == '\n') *eol = '\0';
+struct backend_t {
+    struct search_t *search;
+    const struct format_t *format;
+};
 
-        if (parser->match_blank_line(search->result, line)) continue;
+static void parse_backend_line(void *data, char *line, size_t length) {
+    struct backend_t *backend = data;
+    struct result_t *result = backend->search->result;
+    int nbentry = result->nbentry;
 
-        if (parser->match_file(search->result, line)) continue;
+    backend->format->parse_line(result, line, length);
 
-        if (parser->match_line(search->result, line)) continue;
+    if (result->nbentry != nbentry) notify_search(backend->search);
+}
+
+void spawn_search(struct search_t *search, external_parser_t *parser,
+                  const char *arguments) {
+    struct backend_t backend = {search, parser->format};
+    char options[LINE_MAX * 2];
+    char *argv[MAX_ARGUMENTS];
 
-        fprintf(stderr, "error: unmatched output line:\n\t\"%s\"\n", line);
-        abort();
-        exit(-1);
+    snprintf(options, sizeof(options), "%s %s", parser->default_arguments,
+             arguments);
+
+    /* the interface stops and prints the error once the search is over */
+    if (build_argv(parser->command, options, search->options->pattern,
+                   search->options->directory, argv) == 0) {
+        snprintf(search->error, sizeof(search->error),
+                 "error: empty command for the parser");
+        return;
     }
 
-    free(line);
+    if (run_command(argv, '\n', search, &search->data_mutex,
+                    parse_backend_line, &backend) < 0) {
+        snprintf(search->error, sizeof(search->error),
+                 "error: failed to run command: %s", argv[0]);
+    }
 
-    /* close */
-    pclose(fp);
+    free_argv(argv);
 }
@@ -19,18 +19,34 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef SEARCH_UTILS_H
 #define SEARCH_UTILS_H
 
+#include "line.h"
+#include "parser.h"
 #include "search.h"
 
-typedef struct {
-    const char *default_arguments;
-    int (*match_file)(struct result_t *result, const char *output);
-    int (*match_line)(struct result_t *result, const char *output);
-    int (*match_blank_line)(struct result_t *result, const char *output);
-} external_parser_t;
-
-void resize_string(char **string, size_t *string_size, size_t minimal_size);
-int validate_file(const char *path);
-const char *apply_regex(const char *output, const char *expr);
-void popen_search(struct search_t *search, external_parser_t *parser);
+#define MAX_ARGUMENTS 128
+#define READ_BLOCK_SIZE (1 << 16)
+#define PIPE_SIZE (1 << 20)
+/* milliseconds a stale search may wait for its backend to write */
+#define CANCEL_INTERVAL 50
+
+/* whether path is the file results are currently added to */
+int is_current_file(struct result_t *result, const char *path);
+range_t get_column_match(struct result_t *result, const char *text,
+                         int column);
+typedef void (*record_callback_t)(void *data, char *record, size_t length);
+
+int build_argv(const char *command, const char *options, const char *pattern,
+               const char *directory, char **argv);
+void free_argv(char **argv);
+/* runs argv and hands each record of its output, ended by separator, to
+ * callback with mutex held, returns the wait status of the command or -1 if
+ * it could not be started. The command is killed once search, if any, is
+ * stale */
+int run_command(char **argv, char separator, struct search_t *search,
+                pthread_mutex_t *mutex, record_callback_t callback,
+                void *data);
+/* runs parser with arguments after its default ones */
+void spawn_search(struct search_t *search, external_parser_t *parser,
+                  const char *arguments);
 
 #endif
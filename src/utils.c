@@ -22,6 +22,7 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -33,13 +34,23 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #define CONFIG_DIR "ngp"
 #define CONFIG_FILE "ngprc"
 
+int validate_file(const char *path) {
+    struct stat st;
+
+    if (stat(path, &st) == 0 && S_ISREG(st.st_mode) == 1) return 1;
+
+    return 0;
+}
+
 int is_selectable(struct search_t *search, int index) {
-    int i;
-    struct entry_t *ptr = search->result->start;
+    return next_selectable(search->result, index) == index;
+}
 
-    for (i = 0; i < index; i++) ptr = ptr->next;
+int get_thread_count(struct options_t *options) {
+    if (options->threads > 0) return options->threads;
 
-    return is_entry_selectable(ptr);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? cpus : 1;
 }
 
 char *regex(struct options_t *options, const char *line, const char *pattern) {
@@ -92,3 +103,30 @@ void *from_options_to_parser(struct options_t *options) {
 
     return parser;
 }
+
+/* array of size elements, doubled until it holds needed elements */
+void *grow_array(void *array, int *size, int needed, size_t element) {
+    if (needed <= *size) return array;
+
+    int new_size = *size ? *size * 2 : 256;
+    while (new_size < needed) new_size *= 2;
+
+    *size = new_size;
+    return realloc(array, new_size * element);
+}
+
+/* index of the first of the sorted positions greater or equal to index */
+int lower_bound(const int *positions, int count, int index) {
+    int low = 0;
+    int high = count;
+
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (positions[middle] < index)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
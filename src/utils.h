@@ -25,12 +25,16 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 
 typedef char *(*parser_t)(struct options_t *, const char *, const char *);
 
+int validate_file(const char *path);
 int is_selectable(struct search_t *search, int index);
+int get_thread_count(struct options_t *options);
 char *regex(struct options_t *options, const char *line, const char *pattern);
 void *from_options_to_parser(struct options_t *options);
 char *strstr_wrapper(struct options_t *options, const char *line,
                      const char *pattern);
 char *strcasestr_wrapper(struct options_t *options, const char *line,
                          const char *pattern);
+void *grow_array(void *array, int *size, int needed, size_t element);
+int lower_bound(const int *positions, int count, int index);
 
 #endif /* UTILS_H */
@@ -0,0 +1,404 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE
+
+#include "view.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file.h"
+#include "line.h"
+#include "utils.h"
+
+/* smaller filters are not worth a thread */
+#define MIN_JOB_ENTRIES 4096
+
+struct job_t {
+    struct result_t *result;
+    const char *filter;
+
+    /* entries looked at: an array of a previous view, or the list of the
+     * result from first on */
+    struct entry_t **entries;
+    struct entry_t *first;
+    int count;
+
+    /* lines kept, each one after the header of its file when the line
+     * before belongs to another file */
+    struct entry_t **kept;
+    int nbkept;
+    int first_file;
+    int last_file;
+
+    pthread_t thread;
+    int started;
+};
+
+static void *filter_entries(void *arg) {
+    struct job_t *job = arg;
+    struct entry_t *entry = job->first;
+    char path[PATH_MAX];
+    int file = -1, path_matches = 0;
+    int i;
+
+    job->kept = malloc(2 * job->count * sizeof(*job->kept));
+    job->nbkept = 0;
+    job->first_file = job->last_file = -1;
+
+    for (i = 0; i < job->count; i++) {
+        if (job->entries) entry = job->entries[i];
+
+        struct line_t *line = get_type(entry, LINE_ENTRY);
+        if (!job->entries) entry = entry->next;
+
+        /* headers are added back for the lines kept, blank lines go */
+        if (!line || line->line == 0) continue;
+
+        /* most lines follow a line of the same file */
+        if (line->file != file) {
+            struct file_t *container = get_file(job->result, line->file);
+
+            file = line->file;
+            path_matches = container &&
+                           strcasestr(get_file_path(job->result, container,
+                                                    path, sizeof(path)),
+                                      job->filter);
+        }
+
+        if (!path_matches && !strcasestr(line->entry.data, job->filter))
+            continue;
+
+        if (job->nbkept == 0) job->first_file = file;
+
+        if (file >= 0 && (job->nbkept == 0 || file != job->last_file))
+            job->kept[job->nbkept++] = &get_file(job->result, file)->entry;
+
+        job->kept[job->nbkept++] = &line->entry;
+        job->last_file = file;
+    }
+
+    return NULL;
+}
+
+static void append_job(struct view_t *view, struct job_t *job) {
+    int i = 0;
+
+    if (job->nbkept == 0) return;
+
+    /* the previous job ended in the same file */
+    if (job->first_file >= 0 && job->first_file == view->last_file) i = 1;
+
+    view->entries = grow_array(view->entries, &view->size,
+                               view->nbentry + job->nbkept,
+                               sizeof(*view->entries));
+
+    for (; i < job->nbkept; i++) {
+        if (job->kept[i]->is_selectable) {
+            view->selectable = grow_array(
+                    view->selectable, &view->selectable_size,
+                    view->nbselectable + 1, sizeof(*view->selectable));
+            view->selectable[view->nbselectable++] = view->nbentry;
+        }
+        if (job->kept[i]->type == FILE_ENTRY) {
+            view->files = grow_array(view->files, &view->files_size,
+                                     view->nbfile + 1, sizeof(*view->files));
+            view->files[view->nbfile++] = view->nbentry;
+        }
+        view->entries[view->nbentry++] = job->kept[i];
+    }
+
+    view->last_file = job->last_file;
+}
+
+static void add_row(struct view_t *view, struct entry_t *entry) {
+    view->entries = grow_array(view->entries, &view->size, view->nbentry + 1,
+                               sizeof(*view->entries));
+    view->selectable =
+            grow_array(view->selectable, &view->selectable_size,
+                       view->nbselectable + 1, sizeof(*view->selectable));
+
+    /* every row of a grouped view is selectable */
+    view->selectable[view->nbselectable++] = view->nbentry;
+    view->entries[view->nbentry++] = entry;
+}
+
+/* the lines from entry on, up to the next file or the entries not looked
+ * at yet */
+static void add_file_lines(struct view_t *view, struct entry_t *entry,
+                           int position) {
+    for (; entry && position < view->scanned; position++) {
+        if (entry->type == FILE_ENTRY) break;
+        if (entry->is_selectable) add_row(view, entry);
+        entry = entry->next;
+    }
+}
+
+static void add_group(struct view_t *view, struct result_t *result,
+                      int file) {
+    struct group_t *group = &view->groups[file];
+    int position = result->file_positions[file];
+    int i;
+
+    if (!group->shown) return;
+
+    view->files = grow_array(view->files, &view->files_size,
+                             view->nbfile + 1, sizeof(*view->files));
+    view->file_ids = grow_array(view->file_ids, &view->file_ids_size,
+                                view->nbfile + 1, sizeof(*view->file_ids));
+    view->files[view->nbfile] = view->nbentry;
+    view->file_ids[view->nbfile++] = file;
+    add_row(view, &get_file(result, file)->entry);
+
+    if (!group->expanded) return;
+
+    for (i = 0; i < group->nbline; i++) add_row(view, group->lines[i]);
+    if (!group->lines)
+        add_file_lines(view, get_entry(result, position + 1), position + 1);
+}
+
+static int is_group_shown(struct view_t *view, struct result_t *result,
+                          int file) {
+    char path[PATH_MAX];
+
+    if (!*view->filter) return 1;
+
+    return strcasestr(get_file_path(result, get_file(result, file), path,
+                                    sizeof(path)),
+                      view->filter) != NULL;
+}
+
+/* the files added to the result since, folded */
+static void add_groups(struct view_t *view, struct result_t *result) {
+    view->groups = grow_array(view->groups, &view->groups_size, result->nbfile,
+                              sizeof(*view->groups));
+
+    for (; view->nbgroup < result->nbfile; view->nbgroup++) {
+        struct group_t *group = &view->groups[view->nbgroup];
+
+        memset(group, 0, sizeof(*group));
+        group->shown = is_group_shown(view, result, view->nbgroup);
+        add_group(view, result, view->nbgroup);
+    }
+}
+
+static void build_groups(struct view_t *view, struct result_t *result) {
+    int file;
+
+    view->nbentry = view->nbselectable = view->nbfile = 0;
+
+    for (file = 0; file < view->nbgroup; file++)
+        add_group(view, result, file);
+}
+
+static void update_groups(struct view_t *view, struct result_t *result) {
+    struct group_t *last = view->nbgroup ? &view->groups[view->nbgroup - 1]
+                                         : NULL;
+    int scanned = view->scanned;
+
+    view->scanned = result->nbentry;
+
+    /* lines keep coming for the last file only */
+    if (last && last->shown && last->expanded && !last->lines)
+        add_file_lines(view, get_entry(result, scanned), scanned);
+
+    add_groups(view, result);
+}
+
+/* entries are split in consecutive ranges filtered by as many threads */
+static void run_jobs(struct view_t *view, struct result_t *result,
+                     struct entry_t **entries, int first, int count,
+                     int nbthread) {
+    int nbjob = count / MIN_JOB_ENTRIES;
+    int i;
+
+    if (nbjob > nbthread) nbjob = nbthread;
+    if (nbjob < 1) nbjob = 1;
+
+    struct job_t *jobs = calloc(nbjob, sizeof(*jobs));
+
+    for (i = 0; i < nbjob; i++) {
+        int begin = (long)count * i / nbjob;
+        int end = (long)count * (i + 1) / nbjob;
+
+        jobs[i].result = result;
+        jobs[i].filter = view->filter;
+        jobs[i].count = end - begin;
+        if (entries)
+            jobs[i].entries = entries + begin;
+        else
+            jobs[i].first = get_entry(result, first + begin);
+
+        if (i > 0)
+            jobs[i].started = !pthread_create(&jobs[i].thread, NULL,
+                                              filter_entries, &jobs[i]);
+    }
+
+    /* the first range is filtered by the calling thread */
+    filter_entries(&jobs[0]);
+
+    for (i = 0; i < nbjob; i++) {
+        if (jobs[i].started)
+            pthread_join(jobs[i].thread, NULL);
+        else if (i > 0)
+            filter_entries(&jobs[i]);
+
+        append_job(view, &jobs[i]);
+        free(jobs[i].kept);
+    }
+
+    free(jobs);
+}
+
+/* a filter extending the one of previous only needs to look at the
+ * entries of previous */
+struct view_t *create_view(struct result_t *result, const char *filter,
+                           struct view_t *previous, int nbthread) {
+    struct view_t *view = calloc(1, sizeof(*view));
+
+    snprintf(view->filter, sizeof(view->filter), "%s", filter);
+    view->last_file = -1;
+
+    if (previous && !previous->grouped &&
+        !strncmp(previous->filter, filter, strlen(previous->filter))) {
+        run_jobs(view, result, previous->entries, 0, previous->nbentry,
+                 nbthread);
+        view->scanned = previous->scanned;
+    } else {
+        run_jobs(view, result, NULL, 0, result->nbentry, nbthread);
+        view->scanned = result->nbentry;
+    }
+
+    update_view(view, result);
+    return view;
+}
+
+/* one row per file whose path contains filter, the files expanded in
+ * previous stay expanded */
+struct view_t *create_group_view(struct result_t *result, const char *filter,
+                                 struct view_t *previous) {
+    struct view_t *view = calloc(1, sizeof(*view));
+    int file;
+
+    snprintf(view->filter, sizeof(view->filter), "%s", filter);
+    view->last_file = -1;
+    view->grouped = 1;
+
+    if (previous && previous->grouped) {
+        view->groups = previous->groups;
+        view->nbgroup = previous->nbgroup;
+        view->groups_size = previous->groups_size;
+        view->scanned = previous->scanned;
+        previous->groups = NULL;
+        previous->nbgroup = 0;
+
+        for (file = 0; file < view->nbgroup; file++)
+            view->groups[file].shown = is_group_shown(view, result, file);
+        build_groups(view, result);
+    }
+
+    update_view(view, result);
+    return view;
+}
+
+/* looks at the entries added to the result since */
+void update_view(struct view_t *view, struct result_t *result) {
+    if (view->scanned >= result->nbentry) return;
+
+    if (view->grouped) {
+        update_groups(view, result);
+        return;
+    }
+
+    run_jobs(view, result, NULL, view->scanned,
+             result->nbentry - view->scanned, 1);
+    view->scanned = result->nbentry;
+}
+
+struct entry_t *get_view_entry(struct view_t *view, int index) {
+    if (index < 0 || index >= view->nbentry) return NULL;
+
+    return view->entries[index];
+}
+
+int next_view_selectable(struct view_t *view, int index) {
+    int i = lower_bound(view->selectable, view->nbselectable, index);
+    if (i == view->nbselectable) return -1;
+
+    return view->selectable[i];
+}
+
+int previous_view_selectable(struct view_t *view, int index) {
+    int i = lower_bound(view->selectable, view->nbselectable, index + 1);
+    if (i == 0) return -1;
+
+    return view->selectable[i - 1];
+}
+
+int next_view_file(struct view_t *view, int index) {
+    int i = lower_bound(view->files, view->nbfile, index + 1);
+    if (i == view->nbfile) return -1;
+
+    return view->files[i];
+}
+
+int previous_view_file(struct view_t *view, int index) {
+    int i = lower_bound(view->files, view->nbfile, index);
+    if (i == 0) return -1;
+
+    return view->files[i - 1];
+}
+
+/* group of the file of the row at index in a grouped view, NULL otherwise */
+struct group_t *get_view_group(struct view_t *view, int index, int *file) {
+    if (!view->grouped) return NULL;
+
+    int i = lower_bound(view->files, view->nbfile, index + 1) - 1;
+    if (i < 0) return NULL;
+
+    *file = view->file_ids[i];
+    return &view->groups[*file];
+}
+
+/* expands or folds file, returns the position of its row */
+int toggle_view_group(struct view_t *view, struct result_t *result, int file) {
+    view->groups[file].expanded = !view->groups[file].expanded;
+    build_groups(view, result);
+
+    /* file rows come by increasing ids */
+    return view->files[lower_bound(view->file_ids, view->nbfile, file)];
+}
+
+void free_view(struct view_t *view) {
+    int i;
+
+    if (!view) return;
+
+    for (i = 0; i < view->nbgroup; i++) free(view->groups[i].lines);
+    free(view->groups);
+    free(view->file_ids);
+
+    free(view->entries);
+    free(view->selectable);
+    free(view->files);
+    free(view);
+}
@@ -0,0 +1,86 @@
+/* Copyright (c) 2013 Jonathan Klee
+
+This file is part of ngp.
+
+ngp is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ngp is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ngp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VIEW_H
+#define VIEW_H
+
+#include "entry.h"
+#include "result.h"
+
+#define FILTER_MAX 256
+
+/* a file of a grouped view */
+struct group_t {
+    int expanded;
+    /* whether its path contains the filter */
+    int shown;
+    /* its lines, when the search only counted them, once expanded */
+    struct entry_t **lines;
+    int nbline;
+};
+
+/* the entries of a result whose line or file path contain filter: lines
+ * are kept with the header of their file, nothing is copied */
+struct view_t {
+    char filter[FILTER_MAX];
+
+    struct entry_t **entries;
+    int nbentry;
+    int size;
+
+    /* sorted positions of the selectable entries */
+    int *selectable;
+    int nbselectable;
+    int selectable_size;
+
+    /* sorted positions of the file entries */
+    int *files;
+    int nbfile;
+    int files_size;
+
+    /* a grouped view shows one row per file, with the lines of the
+     * expanded files only, groups are indexed by file id */
+    int grouped;
+    struct group_t *groups;
+    int nbgroup;
+    int groups_size;
+    /* file id of each file entry of a grouped view */
+    int *file_ids;
+    int file_ids_size;
+
+    /* entries of the result looked at so far */
+    int scanned;
+    /* file of the last line kept */
+    int last_file;
+};
+
+struct view_t *create_view(struct result_t *result, const char *filter,
+                           struct view_t *previous, int nbthread);
+struct view_t *create_group_view(struct result_t *result, const char *filter,
+                                 struct view_t *previous);
+void update_view(struct view_t *view, struct result_t *result);
+struct group_t *get_view_group(struct view_t *view, int index, int *file);
+int toggle_view_group(struct view_t *view, struct result_t *result, int file);
+struct entry_t *get_view_entry(struct view_t *view, int index);
+int next_view_selectable(struct view_t *view, int index);
+int previous_view_selectable(struct view_t *view, int index);
+int next_view_file(struct view_t *view, int index);
+int previous_view_file(struct view_t *view, int index);
+void free_view(struct view_t *view);
+
+#endif
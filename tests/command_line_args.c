@@ -207,6 +207,58 @@ static char *test_parser_and_pattern() {
 
         free_options(options);
     }
+    {
+        char *argv[] = {"ngp", "--rg", "--", "pattern"};
+        int argc = sizeof(argv) / sizeof(*argv);
+
+        struct configuration_t *config = NULL;
+        struct options_t *options = NULL;
+        if (!setjmp(buf)) {
+            options = create_options(config, argc, argv);
+        }
+
+        mu_assert_verbose(success == 42);
+        mu_assert_verbose(options->search_type == RG_SEARCH);
+        mu_assert_verbose(!strcmp("pattern", options->pattern));
+        mu_assert_verbose(!strcmp(DEFAULT_RG_CMD,
+                                  options->parsers[RG_SEARCH].command));
+
+        free_options(options);
+    }
+    {
+        char *argv[] = {"ngp", "--auto", "-i", "--", "pattern"};
+        int argc = sizeof(argv) / sizeof(*argv);
+
+        struct configuration_t *config = NULL;
+        struct options_t *options = NULL;
+        if (!setjmp(buf)) {
+            options = create_options(config, argc, argv);
+        }
+
+        mu_assert_verbose(success == 42);
+        mu_assert_verbose(options->search_type == AUTO_SEARCH);
+        mu_assert_verbose(options->incase_option);
+        mu_assert_verbose(!strcmp("pattern", options->pattern));
+
+        free_options(options);
+    }
+    {
+        char *argv[] = {"ngp", "--parser=git", "-i", "--", "pattern"};
+        int argc = sizeof(argv) / sizeof(*argv);
+
+        struct configuration_t *config = NULL;
+        struct options_t *options = NULL;
+        if (!setjmp(buf)) {
+            options = create_options(config, argc, argv);
+        }
+
+        mu_assert_verbose(success == 42);
+        mu_assert_verbose(options->search_type == GIT_SEARCH);
+        mu_assert_verbose(!strcmp("-i", options->parser_options));
+        mu_assert_verbose(!strcmp("pattern", options->pattern));
+
+        free_options(options);
+    }
 
     return 0;
 }
@@ -242,6 +294,21 @@ static char *test_wrong_parser_option() {
 
         free_options(options);
     }
+    {
+        success = 42;
+        char *argv[] = {"ngp", "--parser=unknown", "--", "pattern"};
+        int argc = sizeof(argv) / sizeof(*argv);
+
+        struct configuration_t *config = NULL;
+        struct options_t *options = NULL;
+        if (!setjmp(buf)) {
+            options = create_options(config, argc, argv);
+        }
+
+        mu_assert_verbose(success == 0);
+
+        free_options(options);
+    }
     return 0;
 }
 
@@ -646,6 +713,32 @@ static char *test_invalid_path() {
     return 0;
 }
 
+static char *test_config_without_parsers() {
+    char path[] = "/tmp/ngprc-XXXXXX";
+    char *argv[] = {"ngp", "pattern"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct options_t *options = create_options(NULL, argc, argv);
+    config_t cfg;
+
+    /* the default ngprc only shows parsers in a comment */
+    int fd = mkstemp(path);
+    mu_assert_verbose(fd >= 0);
+    mu_assert_verbose(write(fd, CONFIG_CONTENT, strlen(CONFIG_CONTENT)) ==
+                      (ssize_t)strlen(CONFIG_CONTENT));
+    close(fd);
+
+    config_init(&cfg);
+    mu_assert_verbose(config_read_file(&cfg, path));
+    read_parsers(&cfg, options);
+    mu_assert_verbose(options->nbparser == NUM_SEARCHES);
+
+    config_destroy(&cfg);
+    unlink(path);
+    free_options(options);
+
+    return 0;
+}
+
 char *command_line_arg_tests() {
     mu_run_test(test_show_help);
     mu_run_test(test_get_version);
@@ -659,6 +752,7 @@ char *command_line_arg_tests() {
     mu_run_test(test_parser_and_search_options);
     mu_run_test(test_missing_pattern);
     mu_run_test(test_invalid_path);
+    mu_run_test(test_config_without_parsers);
 
     return 0;
 }
@@ -19,19 +19,35 @@ along with ngp.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdio.h>
 #include <string.h>
 
+#include "ansi.h"
 #include "circular_list.h"
 #include "configuration.h"
 #include "display.h"
+#include "history.h"
+#include "json.h"
 #include "list.h"
 #include "minunit.h"
 #include "ngp_search.h"
+#include "parser.h"
+#include "path.h"
+#include "preview.h"
 #include "search.h"
+#include "view.h"
 
 int tests_run = 0;
 char *command_line_arg_tests();
 
 #include "../src/ngp_search.c"
 
+static void parse_fake_file(struct search_t *search, parser_t parser,
+                            const char *file, int size, char *text,
+                            const char *pattern) {
+    struct batch_t *batch = create_batch(file, 0);
+    parse_text(search, parser, batch, size, text, pattern);
+    commit_batch(search->result, batch);
+    free_batch(batch);
+}
+
 static char *test_no_entry() {
     char *argv[] = {"ngp", "third"};
     int argc = sizeof(argv) / sizeof(*argv);
@@ -40,7 +56,7 @@ static char *test_no_entry() {
     struct search_t *search = create_search(options);
     parser_t parser = from_options_to_parser(search->options);
     char text[] = "this is a the first line\nthis is the second line\n";
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     mu_assert("error in number of entry", search->result->nbentry == 0);
     free_search(search);
     return 0;
@@ -54,7 +70,7 @@ static char *test_one_entry_on_the_first_line() {
     struct search_t *search = create_search(options);
     parser_t parser = from_options_to_parser(search->options);
     char text[] = "this is a the first line\nthis is the second line\n";
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     mu_assert("error in number of entry", search->result->nbentry == 2);
     free_search(search);
     return 0;
@@ -68,7 +84,7 @@ static char *test_one_entry_on_the_second_line() {
     struct search_t *search = create_search(options);
     parser_t parser = from_options_to_parser(search->options);
     char text[] = "this is a the first line\nthis is the second line\n";
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     mu_assert("error in number of entry", search->result->nbentry == 2);
     free_search(search);
     return 0;
@@ -83,7 +99,7 @@ static char *test_one_entry_incase() {
     struct search_t *search = create_search(options);
     parser_t parser = from_options_to_parser(search->options);
     char text[] = "this is a the first line\nthis is the second line\n";
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     mu_assert("error in number of entry", search->result->nbentry == 2);
     free_search(search);
     return 0;
@@ -97,7 +113,7 @@ static char *test_two_entries() {
     struct search_t *search = create_search(options);
     parser_t parser = from_options_to_parser(search->options);
     char text[] = "this is a the first line\nthis is the second line\n";
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     mu_assert("error in number of entry", search->result->nbentry == 3);
     free_search(search);
     return 0;
@@ -112,7 +128,7 @@ static char *test_regexp_start_of_line() {
     struct search_t *search = create_search(options);
     parser_t parser = from_options_to_parser(search->options);
     char text[] = "this is a the first line\nthis is the second line\n";
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     mu_assert("error in number of entry", search->result->nbentry == 3);
     free_search(search);
     return 0;
@@ -127,12 +143,61 @@ static char *test_wrong_regexp() {
     struct search_t *search = create_search(options);
     parser_t parser = from_options_to_parser(search->options);
     char text[] = "this is a the first line\nthis is the second line\n";
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     mu_assert("error in number of entry", search->result->nbentry == 0);
     free_search(search);
     return 0;
 }
 
+static char *test_long_line_is_cropped() {
+    char *argv[] = {"ngp", "needle"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+    options->max_line_length = 32;
+    options->line_window = 4;
+    struct search_t *search = create_search(options);
+    parser_t parser = from_options_to_parser(search->options);
+    char text[] =
+            "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaxxxxneedlexxxxbbbbbbbbbbbb"
+            "bbbbbbbbbbbbbbbbbbbbbbbb\n";
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
+    mu_assert("error in number of entry", search->result->nbentry == 2);
+    struct line_t *line = get_type(search->result->entries, LINE_ENTRY);
+    mu_assert("line not cropped", strcmp(line->entry.data, "xxxxneedlexxxx") == 0);
+    mu_assert("wrong line length", line->length == strlen(text) - 1);
+    mu_assert("wrong line offset", line->offset == 40);
+    mu_assert("wrong highlight", line->nbhighlight == 1 &&
+                                         get_highlights(line)->begin == 4 &&
+                                         get_highlights(line)->end == 10);
+    free_search(search);
+    return 0;
+}
+
+static char *test_highlights_are_aligned() {
+    struct result_t *result = create_result();
+    const char *text = "a needle in a longer line";
+    char prefix[32];
+    range_t match = {2, 8};
+    int length;
+
+    result->max_line_length = DEFAULT_MAX_LINE_LENGTH;
+    result->line_window = DEFAULT_LINE_WINDOW;
+    for (length = 8; length <= strlen(text); length++) {
+        snprintf(prefix, sizeof(prefix), "%.*s", length, text);
+        struct line_t *line = get_type(
+                create_highlighted_line(result, prefix, 1, &match, 1),
+                LINE_ENTRY);
+        mu_assert("test_highlights_are_aligned failed",
+                  (size_t)get_highlights(line) % _Alignof(range_t) == 0);
+        mu_assert("test_highlights_are_aligned failed",
+                  get_highlights(line)->end == 8);
+    }
+
+    free_result(result);
+    return 0;
+}
+
 static char *test_is_specific_file_ok() {
     char *argv[] = {"ngp", "pattern"};
     int argc = sizeof(argv) / sizeof(*argv);
@@ -225,7 +290,7 @@ static char *test_cursor_down() {
     parser_t parser = from_options_to_parser(search->options);
     terminal_line_nb = 10;
 
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     move_cursor_down(display, search, terminal_line_nb);
     mu_assert("test_cursor_down failed", display->cursor == 2);
     free_search(search);
@@ -248,7 +313,7 @@ static char *test_cursor_down_end_of_entries() {
     parser_t parser = from_options_to_parser(search->options);
     terminal_line_nb = 10;
 
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     move_cursor_down(display, search, terminal_line_nb);
     mu_assert("test_cursor_down_end_of_entries failed", display->cursor == 1);
     free_search(search);
@@ -272,8 +337,8 @@ static char *test_cursor_down_skip_file() {
     parser_t parser = from_options_to_parser(search->options);
     terminal_line_nb = 10;
 
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
-    parse_text(search, parser, "fake_file2", strlen(text2), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file2", strlen(text2), text, options->pattern);
     move_cursor_down(display, search, terminal_line_nb);
     mu_assert("test_cursor_down_skip_file failed", display->cursor == 3);
     free_search(search);
@@ -282,6 +347,42 @@ static char *test_cursor_down_skip_file() {
     return 0;
 }
 
+static char *test_next_and_previous_file() {
+    struct display_t *display;
+    int terminal_line_nb;
+    char text[] = "first line\nsecond line\n";
+    char *argv[] = {"ngp", "line"};
+    int argc = sizeof(argv) / sizeof(*argv);
+
+    display = create_display();
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+    struct search_t *search = create_search(options);
+    parser_t parser = from_options_to_parser(search->options);
+    terminal_line_nb = 4;
+
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file2", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file3", strlen(text), text, options->pattern);
+    move_next_file(display, search, terminal_line_nb);
+    mu_assert("test_next_and_previous_file failed", display->index == 4 && display->cursor == 0);
+    move_next_file(display, search, terminal_line_nb);
+    mu_assert("test_next_and_previous_file failed", display->index == 4 && display->cursor == 3);
+    move_next_file(display, search, terminal_line_nb);
+    mu_assert("test_next_and_previous_file failed", display->index == 4 && display->cursor == 3);
+    move_previous_file(display, search, terminal_line_nb);
+    mu_assert("test_next_and_previous_file failed", display->index == 4 && display->cursor == 0);
+    move_cursor_down(display, search, terminal_line_nb);
+    move_previous_file(display, search, terminal_line_nb);
+    mu_assert("test_next_and_previous_file failed", display->index == 0 && display->cursor == 1);
+    move_previous_file(display, search, terminal_line_nb);
+    mu_assert("test_next_and_previous_file failed", display->index == 0 && display->cursor == 1);
+    free_search(search);
+    free_display(display);
+
+    return 0;
+}
+
 static char *test_cursor_down_end_of_page() {
     struct display_t *display;
     int terminal_line_nb;
@@ -298,7 +399,7 @@ static char *test_cursor_down_end_of_page() {
     parser_t parser = from_options_to_parser(search->options);
     terminal_line_nb = 3;
 
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     move_cursor_down(display, search, terminal_line_nb);
     move_cursor_down(display, search, terminal_line_nb);
     mu_assert("test_cursor_down_end_of_page failed", display->cursor == 0);
@@ -323,8 +424,8 @@ static char *test_cursor_down_end_of_page_skip_file() {
     parser_t parser = from_options_to_parser(search->options);
     terminal_line_nb = 3;
 
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
-    parse_text(search, parser, "fake_file2", strlen(text2), text2, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file2", strlen(text2), text2, options->pattern);
     move_cursor_down(display, search, terminal_line_nb);
     move_cursor_down(display, search, terminal_line_nb);
     mu_assert("test_cursor_down_end_of_page_skip_file failed",
@@ -349,7 +450,7 @@ static char *test_cursor_up() {
     parser_t parser = from_options_to_parser(search->options);
     terminal_line_nb = 10;
 
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     display->cursor = 2;
     move_cursor_up(display, search, terminal_line_nb);
     mu_assert("test_cursor_up failed", display->cursor == 1);
@@ -373,7 +474,7 @@ static char *test_cursor_up_top_first_page() {
     parser_t parser = from_options_to_parser(search->options);
     terminal_line_nb = 10;
 
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     move_cursor_up(display, search, terminal_line_nb);
     mu_assert("test_cursor_up_top_first_page failed", display->cursor == 1);
     free_search(search);
@@ -397,8 +498,8 @@ static char *test_cursor_up_skip_file() {
     parser_t parser = from_options_to_parser(search->options);
     terminal_line_nb = 10;
 
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
-    parse_text(search, parser, "fake_file2", strlen(text2), text2, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file2", strlen(text2), text2, options->pattern);
     move_cursor_down(display, search, terminal_line_nb);
     move_cursor_up(display, search, terminal_line_nb);
     mu_assert("test_cursor_up_skip_file failed", display->cursor == 1);
@@ -424,7 +525,7 @@ static char *test_cursor_up_page_up() {
     parser_t parser = from_options_to_parser(search->options);
     terminal_line_nb = 3;
 
-    parse_text(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
     move_cursor_down(display, search, terminal_line_nb);
     move_cursor_down(display, search, terminal_line_nb);
     mu_assert("test_cursor_up_skip_file failed", display->cursor == 0);
@@ -436,6 +537,853 @@ static char *test_cursor_up_page_up() {
     return 0;
 }
 
+static char *test_selectable_index() {
+    char *argv[] = {"ngp", "line"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+    struct search_t *search = create_search(options);
+    parser_t parser = from_options_to_parser(search->options);
+    char text[] = "this is the first line\nthis is the second line\n";
+    char text2[] = "this is the first line\n";
+
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file2", strlen(text2), text2, options->pattern);
+    mu_assert("test_selectable_index failed",
+              next_selectable(search->result, 0) == 1);
+    mu_assert("test_selectable_index failed",
+              next_selectable(search->result, 3) == 4);
+    mu_assert("test_selectable_index failed",
+              next_selectable(search->result, 5) == -1);
+    mu_assert("test_selectable_index failed",
+              previous_selectable(search->result, 3) == 2);
+    mu_assert("test_selectable_index failed",
+              previous_selectable(search->result, 0) == -1);
+    free_search(search);
+
+    return 0;
+}
+
+static char *test_get_entry() {
+    char *argv[] = {"ngp", "line"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+    struct search_t *search = create_search(options);
+    parser_t parser = from_options_to_parser(search->options);
+    char text[4096] = "";
+    int i;
+
+    for (i = 0; i < 200; i++) strcat(text, "line\n");
+
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
+    struct line_t *line = get_type(get_entry(search->result, 150), LINE_ENTRY);
+    mu_assert("test_get_entry failed", line && line->line == 150);
+    mu_assert("test_get_entry failed", get_entry(search->result, 201) == NULL);
+    free_search(search);
+
+    return 0;
+}
+
+static char *test_line_owning_file() {
+    char *argv[] = {"ngp", "line"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+    struct search_t *search = create_search(options);
+    parser_t parser = from_options_to_parser(search->options);
+    char text[] = "this is the first line\nthis is the second line\n";
+    char text2[] = "this is the first line\n";
+
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
+    parse_fake_file(search, parser, "fake_file2", strlen(text2), text2, options->pattern);
+    struct line_t *line = get_type(get_entry(search->result, 4), LINE_ENTRY);
+    struct file_t *file = get_file(search->result, line->file);
+    mu_assert("test_line_owning_file failed",
+              strcmp(file->entry.data, "fake_file2") == 0);
+    free_search(search);
+
+    return 0;
+}
+
+static char *test_spill_results() {
+    char *argv[] = {"ngp", "line"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+    options->memory_budget = 1;
+    struct search_t *search = create_search(options);
+    parser_t parser = from_options_to_parser(search->options);
+    int nbline = 60000;
+    char *text = calloc(nbline, strlen("line\n") + 1);
+    int i;
+
+    for (i = 0; i < nbline; i++) memcpy(text + i * 5, "line\n", 5);
+
+    parse_fake_file(search, parser, "fake_file", strlen(text), text, options->pattern);
+    mu_assert("test_spill_results failed", search->result->spill_size > 0);
+    mu_assert("test_spill_results failed",
+              search->result->memory_used <= search->result->memory_budget);
+    struct line_t *line = get_type(get_entry(search->result, 59000), LINE_ENTRY);
+    mu_assert("test_spill_results failed", line && line->line == 59000);
+    free(text);
+    free_search(search);
+
+    return 0;
+}
+
+static void write_fake_file(const char *path, const char *text) {
+    FILE *file = fopen(path, "w");
+    fputs(text, file);
+    fclose(file);
+}
+
+static char *test_sorted_search() {
+    char directory[] = "/tmp/ngp-test-XXXXXX";
+    char path[PATH_MAX];
+    char *argv[] = {"ngp", "needle"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+    char *expected[] = {"a.c", "a/x.c", "b.c"};
+    int i;
+
+    mu_assert("test_sorted_search failed", mkdtemp(directory) != NULL);
+    snprintf(path, sizeof(path), "%s/a", directory);
+    mkdir(path, 0700);
+    for (i = 0; i < 3; i++) {
+        snprintf(path, sizeof(path), "%s/%s", directory, expected[2 - i]);
+        write_fake_file(path, "a needle\nno match\nneedle again\n");
+    }
+
+    add_element(&options->extension, ".c");
+    strcpy(options->directory, directory);
+    options->sort_option = 1;
+    options->threads = 4;
+    struct search_t *search = create_search(options);
+    do_ngp_search(search);
+
+    mu_assert("test_sorted_search failed", search->result->nbfile == 3);
+    for (i = 0; i < 3; i++) {
+        get_file_path(search->result, get_file(search->result, i), path,
+                      sizeof(path));
+        mu_assert("test_sorted_search failed",
+                  strcmp(path + strlen(directory) + 1, expected[i]) == 0);
+    }
+
+    for (i = 0; i < 3; i++) {
+        snprintf(path, sizeof(path), "%s/%s", directory, expected[i]);
+        unlink(path);
+    }
+    snprintf(path, sizeof(path), "%s/a", directory);
+    rmdir(path);
+    rmdir(directory);
+    free_search(search);
+
+    return 0;
+}
+
+static void ignore_record(void *data, char *record, size_t length) {}
+
+static char *test_search_restart() {
+    char directory[] = "/tmp/ngp-test-XXXXXX";
+    char path[PATH_MAX];
+    char command[PATH_MAX * 2];
+    char *argv[] = {"ngp", "needle"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+    struct search_t *first, *second;
+
+    mu_assert("test_search_restart failed", mkdtemp(directory) != NULL);
+    snprintf(path, sizeof(path), "%s/a.c", directory);
+    write_fake_file(path, "a needle\nthread\n");
+
+    add_element(&options->extension, ".c");
+    strcpy(options->directory, directory);
+    first = create_search(options);
+    do_ngp_search(first);
+    mu_assert("test_search_restart failed", first->result->nbentry == 2);
+    mu_assert("test_search_restart failed", first->listing->complete);
+
+    /* the next search submits the files listed by the first one */
+    snprintf(path, sizeof(path), "%s/b.c", directory);
+    write_fake_file(path, "thread\n");
+    set_pattern(options, "thread");
+    second = create_search(options);
+    mu_assert("test_search_restart failed",
+              strcmp(second->result->pattern, "thread") == 0);
+    second->listing = first->listing;
+    first->listing = NULL;
+    do_ngp_search(second);
+    mu_assert("test_search_restart failed", second->result->nbfile == 1);
+
+    /* a search stops once a newer generation starts */
+    cancel_searches();
+    mu_assert("test_search_restart failed", is_search_stale(second));
+    second->listing->complete = 0;
+    do_ngp_search(second);
+    mu_assert("test_search_restart failed", !second->listing->complete);
+
+    /* and kills the command it runs, however long its output is */
+    char *endless[] = {"yes", NULL};
+    int status = run_command(endless, '\n', second, NULL, ignore_record, NULL);
+    mu_assert("test_search_restart failed",
+              WIFSIGNALED(status) && WTERMSIG(status) == SIGTERM);
+
+    snprintf(command, sizeof(command), "rm -rf %s", directory);
+    mu_assert("test_search_restart failed", system(command) == 0);
+    first->options = NULL;
+    free_search(first);
+    free_search(second);
+
+    return 0;
+}
+
+static char *test_search_error() {
+    char *argv[] = {"ngp", "needle"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+
+    /* the search reports a backend that cannot run instead of exiting */
+    free(options->parsers[RG_SEARCH].command);
+    options->parsers[RG_SEARCH].command = strdup("ngp-missing-backend %2$s");
+    options->search_type = RG_SEARCH;
+    struct search_t *search = create_search(options);
+    do_search(search);
+    mu_assert("test_search_error failed", search->result->nbentry == 0);
+    mu_assert("test_search_error failed",
+              strstr(search->error, "ngp-missing-backend") != NULL);
+    free_search(search);
+
+    return 0;
+}
+
+static char *test_scan_file() {
+    char path[] = "/tmp/ngp-scan-XXXXXX";
+    char *argv[] = {"ngp", "-e", "ne+dle"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+    struct search_t *search = create_search(options);
+    struct batch_t *batch;
+    FILE *file;
+    int fd, i;
+
+    fd = mkstemp(path);
+    mu_assert("test_scan_file failed", fd >= 0);
+    file = fdopen(fd, "w");
+    for (i = 0; i < 3 * STALE_CHECK_LINES; i++)
+        fputs(i % 1000 == 0 ? "a needle\n" : "thread\n", file);
+    fclose(file);
+
+    /* a restarted search changed the pattern and made this one stale */
+    set_pattern(options, "thr.ad");
+    cancel_searches();
+    batch = scan_file(search, path);
+    mu_assert("test_scan_file failed", batch->nbline == 13);
+    mu_assert("test_scan_file failed", options->pcre_compiled == NULL);
+    free_batch(batch);
+
+    unlink(path);
+    free_search(search);
+
+    return 0;
+}
+
+static char *test_hybrid_search() {
+    char directory[] = "/tmp/ngp-test-XXXXXX";
+    char cwd[PATH_MAX];
+    char command[PATH_MAX * 2];
+    char path[PATH_MAX];
+    char *argv[] = {"ngp", "needle"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+    int tracked = 0, untracked = 0, ignored = 0;
+    FILE *binary;
+    int i;
+
+    mu_assert("test_hybrid_search failed", mkdtemp(directory) != NULL);
+    mu_assert("test_hybrid_search failed", getcwd(cwd, sizeof(cwd)) != NULL);
+    mu_assert("test_hybrid_search failed", chdir(directory) == 0);
+
+    write_fake_file("tracked.c", "a needle\nno match\n");
+    write_fake_file("notes.txt", "a needle\n");
+    write_fake_file("untracked.c", "needle again\n");
+    write_fake_file("ignored.c", "needle\n");
+    write_fake_file(".gitignore", "ignored.c\n");
+    binary = fopen("binary.c", "w");
+    fwrite("needle\n\0\n", 1, 9, binary);
+    fclose(binary);
+    mu_assert("test_hybrid_search failed",
+              system("git init -q && git add tracked.c notes.txt binary.c && "
+                     "git -c user.name=ngp -c user.email=ngp@localhost "
+                     "commit -qm tracked") == 0);
+    mu_assert("test_hybrid_search failed",
+              system("mkdir nested && git -C nested init -q") == 0);
+    write_fake_file("nested/inner.c", "needle\n");
+
+    add_element(&options->extension, ".c");
+    options->search_type = HYBRID_SEARCH;
+    options->threads = 2;
+    struct search_t *search = create_search(options);
+    do_search(search);
+
+    /* every file shows up once, and only the files nat would look into */
+    for (i = 0; i < search->result->nbfile; i++) {
+        get_file_path(search->result, get_file(search->result, i), path,
+                      sizeof(path));
+        if (!strcmp(path, "tracked.c")) tracked++;
+        if (!strcmp(path, "untracked.c")) untracked++;
+    }
+    mu_assert("test_hybrid_search failed", search->result->nbfile == 2);
+    mu_assert("test_hybrid_search failed", tracked == 1 && untracked == 1);
+    mu_assert("test_hybrid_search failed", search->result->nbselectable == 2);
+    search->options = NULL;
+    free_search(search);
+
+    /* chosen by an auto search, it reads the files nat reads */
+    options->search_type = NGP_SEARCH;
+    struct search_t *nat = create_search(options);
+    do_search(nat);
+    options->search_type = HYBRID_SEARCH;
+    search = create_search(options);
+    search->every_file = 1;
+    do_search(search);
+
+    for (i = 0; i < search->result->nbfile; i++) {
+        get_file_path(search->result, get_file(search->result, i), path,
+                      sizeof(path));
+        if (!strcmp(path, "ignored.c")) ignored++;
+    }
+    mu_assert("test_hybrid_search failed", ignored == 1);
+    mu_assert("test_hybrid_search failed", search->result->nbfile == 5);
+    mu_assert("test_hybrid_search failed",
+              search->result->nbfile == nat->result->nbfile);
+    mu_assert("test_hybrid_search failed",
+              search->result->nbselectable == nat->result->nbselectable);
+    nat->options = NULL;
+    free_search(nat);
+
+    mu_assert("test_hybrid_search failed", chdir(cwd) == 0);
+    snprintf(command, sizeof(command), "rm -rf %s", directory);
+    mu_assert("test_hybrid_search failed", system(command) == 0);
+    free_search(search);
+
+    return 0;
+}
+
+static char *test_history() {
+    char path[] = "/tmp/ngp-history-XXXXXX";
+    struct history_t *history = malloc(sizeof(*history));
+    struct sample_t *sample;
+    int fd, i;
+
+    fd = mkstemp(path);
+    mu_assert("test_history failed", fd >= 0);
+    close(fd);
+
+    read_history(history, path);
+    mu_assert("test_history failed", history->nbsample == 0);
+
+    add_sample(history, "/src", "nat", 10, 100);
+    add_sample(history, "/src", "nat", 20, 200);
+    add_sample(history, "/src", "ag", 5, 50);
+    mu_assert("test_history failed", write_history(history, path) == 0);
+
+    read_history(history, path);
+    mu_assert("test_history failed", history->nbsample == 2);
+    sample = get_sample(history, "/src", "nat");
+    mu_assert("test_history failed", sample && sample->runs == 2);
+    mu_assert("test_history failed",
+              sample->first_result > 10 && sample->first_result < 20);
+    mu_assert("test_history failed", sample->total > 100 &&
+                                             sample->total < 200);
+    mu_assert("test_history failed", !get_sample(history, "/", "nat"));
+
+    /* the least recently updated samples go first */
+    for (i = 0; i < HISTORY_SIZE; i++) {
+        char root[PATH_MAX];
+        snprintf(root, sizeof(root), "/root%d", i);
+        add_sample(history, root, "git", 1, 1);
+    }
+    mu_assert("test_history failed", history->nbsample == HISTORY_SIZE);
+    mu_assert("test_history failed", !get_sample(history, "/src", "ag"));
+
+    unlink(path);
+    free(history);
+
+    return 0;
+}
+
+static char *test_auto_search() {
+    char directory[] = "/tmp/ngp-test-XXXXXX";
+    char path[PATH_MAX];
+    char root[PATH_MAX];
+    char command[PATH_MAX * 2];
+    char *argv[] = {"ngp", "needle"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+    struct history_t *history = malloc(sizeof(*history));
+    struct search_t *first, *second;
+
+    mu_assert("test_auto_search failed", mkdtemp(directory) != NULL);
+    snprintf(path, sizeof(path), "%s/a.c", directory);
+    write_fake_file(path, "a needle\n");
+    setenv("XDG_CACHE_HOME", directory, 1);
+
+    add_element(&options->extension, ".c");
+    strcpy(options->directory, directory);
+    options->search_type = AUTO_SEARCH;
+    first = create_search(options);
+    do_search(first);
+    mu_assert("test_auto_search failed", first->result->nbentry == 2);
+    mu_assert("test_auto_search failed", first->type == NGP_SEARCH);
+
+    /* the next search chooses again and is timed too */
+    mu_assert("test_auto_search failed", options->search_type == AUTO_SEARCH);
+    second = create_search(options);
+    mu_assert("test_auto_search failed", second->type == AUTO_SEARCH);
+
+    mu_assert("test_auto_search failed", realpath(directory, root) != NULL);
+    snprintf(path, sizeof(path), "%s/ngp/history", directory);
+    read_history(history, path);
+    mu_assert("test_auto_search failed",
+              get_sample(history, root, "nat") != NULL);
+
+    unsetenv("XDG_CACHE_HOME");
+    snprintf(command, sizeof(command), "rm -rf %s", directory);
+    mu_assert("test_auto_search failed", system(command) == 0);
+    second->options = NULL;
+    free_search(second);
+    free_search(first);
+    free(history);
+
+    return 0;
+}
+
+static char *test_notify_search() {
+    char *argv[] = {"ngp", "needle"};
+    int argc = sizeof(argv) / sizeof(*argv);
+    struct configuration_t *config = NULL;
+    struct options_t *options = create_options(config, argc, argv);
+    struct search_t *search = create_search(options);
+    char buffer[4];
+    int fds[2];
+
+    mu_assert("test_notify_search failed", pipe(fds) == 0);
+    notify_search(search);
+    search->wakeup_fd = fds[1];
+
+    /* a single wake up until the interface drew the results */
+    notify_search(search);
+    notify_search(search);
+    close(fds[1]);
+    mu_assert("test_notify_search failed", read(fds[0], buffer, 4) == 1);
+    mu_assert("test_notify_search failed", search->notified);
+
+    close(fds[0]);
+    free_search(search);
+
+    return 0;
+}
+
+static char *test_intern_path() {
+    struct path_table_t *table = create_path_table();
+    char path[PATH_MAX];
+    const char *first, *second, *absolute;
+
+    int directory = intern_path(table, "./src/search.c", &first);
+    mu_assert("test_intern_path failed",
+              intern_path(table, "src//ngp_search.c", &second) == directory);
+    mu_assert("test_intern_path failed", table->nbdirectory == 1);
+    mu_assert("test_intern_path failed",
+              strcmp(build_path(table, directory, first, path, sizeof(path)),
+                     "src/search.c") == 0);
+
+    directory = intern_path(table, "/usr/include/stdio.h", &absolute);
+    mu_assert("test_intern_path failed",
+              strcmp(build_path(table, directory, absolute, path, sizeof(path)),
+                     "/usr/include/stdio.h") == 0);
+    mu_assert("test_intern_path failed",
+              intern_path(table, "file.c", &first) == NO_DIRECTORY);
+    free_path_table(table);
+
+    return 0;
+}
+
+static char *test_tokenize_ansi() {
+    struct ansi_line_t line;
+    char ag[] = "\033[1;33m28\033[0m\033[K:void do_\033[30;43mag_\033[0m"
+                "\033[Ksearch(struct search_t *search);";
+    char git[] = "57\033[36m-\033[m            return do_git_search();";
+    char file[] = "\033[1;32m2013/ngp.c\033[0m\033[K";
+    char text[] = "12\033[1;31m:\033[m";
+
+    tokenize_ansi(ag, &line);
+    mu_assert("test_tokenize_ansi failed", line.line_number == 28);
+    mu_assert("test_tokenize_ansi failed", line.separator == ':');
+    mu_assert("test_tokenize_ansi failed",
+              strcmp(line.text, "void do_ag_search(struct search_t *search);") ==
+                      0);
+    mu_assert("test_tokenize_ansi failed", line.nbhighlight == 1);
+    mu_assert("test_tokenize_ansi failed", line.highlights[0].begin == 8);
+    mu_assert("test_tokenize_ansi failed", line.highlights[0].end == 11);
+
+    tokenize_ansi(git, &line);
+    mu_assert("test_tokenize_ansi failed", line.line_number == 57);
+    mu_assert("test_tokenize_ansi failed", line.separator == '-');
+    mu_assert("test_tokenize_ansi failed", line.nbhighlight == 0);
+
+    tokenize_ansi(file, &line);
+    mu_assert("test_tokenize_ansi failed", line.line_number == 0);
+    mu_assert("test_tokenize_ansi failed", strcmp(line.text, "2013/ngp.c") == 0);
+
+    tokenize_ansi_text(text, &line);
+    mu_assert("test_tokenize_ansi failed", line.line_number == 0);
+    mu_assert("test_tokenize_ansi failed", strcmp(line.text, "12:") == 0);
+    mu_assert("test_tokenize_ansi failed", line.highlights[0].begin == 2);
+
+    return 0;
+}
+
+struct json_test_t {
+    char path[64];
+    int line_number;
+    int start;
+};
+
+static void read_json_test(void *data, const char **keys, int depth,
+                           struct json_value_t *value) {
+    struct json_test_t *test = data;
+
+    if (depth == 3 && !strcmp(keys[1], "path"))
+        strcpy(test->path, value->text);
+    else if (depth == 2 && !strcmp(keys[1], "line_number"))
+        test->line_number = atoi(value->text);
+    else if (depth == 4 && keys[2] == NULL && !strcmp(keys[3], "start"))
+        test->start = atoi(value->text);
+}
+
+static char *test_parse_json() {
+    struct json_test_t test = {"", 0, 0};
+    char event[] = "{\"type\":\"match\",\"data\":{\"path\":{\"text\":"
+                   "\"src/\\u00e9t\\u00e9.c\"},\"line_number\":30,"
+                   "\"submatches\":[{\"match\":{\"text\":\"rg_\"},"
+                   "\"start\":8,\"end\":11}]}}";
+    char truncated[] = "{\"type\":\"match\",\"data\":{\"path\":";
+
+    mu_assert("test_parse_json failed",
+              parse_json(event, strlen(event), read_json_test, &test));
+    mu_assert("test_parse_json failed",
+              strcmp(test.path, "src/\xc3\xa9t\xc3\xa9.c") == 0);
+    mu_assert("test_parse_json failed", test.line_number == 30);
+    mu_assert("test_parse_json failed", test.start == 8);
+    mu_assert("test_parse_json failed",
+              !parse_json(truncated, strlen(truncated), read_json_test, &test));
+
+    return 0;
+}
+
+static char *test_null_format() {
+    struct result_t *result = create_result();
+    const struct format_t *format = get_format("null");
+    char colored[] = "src/a.c\0" "3\0" "5\0" "int \033[31mmain\033[m()";
+    char plain[] = "src/a.c\0" "7\0" "1\0" "main();";
+    char context[] = "src/a.c\0" "8\0" "}";
+    struct line_t *line;
+
+    result->max_line_length = DEFAULT_MAX_LINE_LENGTH;
+    result->pattern = strdup("mai");
+
+    format->parse_line(result, colored, sizeof(colored) - 1);
+    format->parse_line(result, plain, sizeof(plain) - 1);
+    format->parse_line(result, context, sizeof(context) - 1);
+    mu_assert("test_null_format failed", result->nbentry == 4);
+
+    line = get_type(get_entry(result, 1), LINE_ENTRY);
+    mu_assert("test_null_format failed",
+              strcmp(line->entry.data, "int main()") == 0);
+    mu_assert("test_null_format failed", line->nbhighlight == 1);
+    mu_assert("test_null_format failed", get_highlights(line)->begin == 4 &&
+                                                 get_highlights(line)->end == 8);
+
+    /* without colors, the pattern at the column of the match */
+    line = get_type(get_entry(result, 2), LINE_ENTRY);
+    mu_assert("test_null_format failed", line->nbhighlight == 1);
+    mu_assert("test_null_format failed", get_highlights(line)->begin == 0 &&
+                                                 get_highlights(line)->end == 3);
+
+    line = get_type(get_entry(result, 3), LINE_ENTRY);
+    mu_assert("test_null_format failed", !line->entry.is_selectable);
+    free_result(result);
+
+    return 0;
+}
+
+static char *test_json_format() {
+    struct result_t *result = create_result();
+    const struct format_t *format = get_format("json");
+    char begin[] = "{\"type\":\"begin\","
+                   "\"data\":{\"path\":{\"text\":\"./src/a.c\"}}}";
+    char match[] = "{\"type\":\"match\",\"data\":{\"path\":{\"text\":\"./src/a.c\"},"
+                   "\"lines\":{\"text\":\"int main() { return main(); }\\n\"},"
+                   "\"line_number\":3,\"absolute_offset\":20,\"submatches\":["
+                   "{\"match\":{\"text\":\"main\"},\"start\":4,\"end\":8},"
+                   "{\"match\":{\"text\":\"main\"},\"start\":20,\"end\":24}]}}";
+    char context[] = "{\"type\":\"context\",\"data\":{\"path\":{\"text\":"
+                     "\"./src/a.c\"},\"lines\":{\"text\":\"}\\n\"},"
+                     "\"line_number\":4,\"absolute_offset\":50,"
+                     "\"submatches\":[]}}";
+    char end[] = "{\"type\":\"end\",\"data\":{\"path\":{\"text\":\"./src/a.c\"},"
+                 "\"binary_offset\":null,\"stats\":{\"matches\":2}}}";
+    char path[PATH_MAX];
+    struct line_t *line;
+
+    result->max_line_length = DEFAULT_MAX_LINE_LENGTH;
+
+    format->parse_line(result, begin, strlen(begin));
+    format->parse_line(result, match, strlen(match));
+    format->parse_line(result, context, strlen(context));
+    format->parse_line(result, end, strlen(end));
+
+    mu_assert("test_json_format failed", result->nbfile == 1);
+    mu_assert("test_json_format failed", result->nbentry == 3);
+    get_file_path(result, get_file(result, 0), path, sizeof(path));
+    mu_assert("test_json_format failed", strcmp(path, "src/a.c") == 0);
+
+    line = get_type(get_entry(result, 1), LINE_ENTRY);
+    mu_assert("test_json_format failed", line->line == 3);
+    mu_assert("test_json_format failed", line->file == 0);
+    mu_assert("test_json_format failed", line->entry.is_selectable);
+    mu_assert("test_json_format failed",
+              strcmp(line->entry.data, "int main() { return main(); }") == 0);
+    mu_assert("test_json_format failed", line->nbhighlight == 2);
+    mu_assert("test_json_format failed", get_highlights(line)[0].begin == 4 &&
+                                                 get_highlights(line)[0].end == 8);
+    mu_assert("test_json_format failed", get_highlights(line)[1].begin == 20 &&
+                                                 get_highlights(line)[1].end == 24);
+
+    line = get_type(get_entry(result, 2), LINE_ENTRY);
+    mu_assert("test_json_format failed", line->line == 4);
+    mu_assert("test_json_format failed", !line->entry.is_selectable);
+    mu_assert("test_json_format failed", strcmp(line->entry.data, "}") == 0);
+    free_result(result);
+
+    return 0;
+}
+
+static char *test_grep_format() {
+    struct result_t *result = create_result();
+    const struct format_t *format = get_format("vimgrep");
+    result->max_line_length = DEFAULT_MAX_LINE_LENGTH;
+    char first[] = "./src/a.c:3:5:int main()";
+    char second[] = "src/a.c:7:1:main();";
+    char third[] = "src/b.c:1:1:main";
+
+    mu_assert("test_grep_format failed", get_format("unknown") == NULL);
+
+    format->parse_line(result, first, strlen(first));
+    format->parse_line(result, second, strlen(second));
+    format->parse_line(result, third, strlen(third));
+
+    mu_assert("test_grep_format failed", result->nbfile == 2);
+    mu_assert("test_grep_format failed", result->nbentry == 5);
+
+    struct line_t *line = get_type(get_entry(result, 1), LINE_ENTRY);
+    mu_assert("test_grep_format failed", line->line == 3);
+    mu_assert("test_grep_format failed", line->file == 0);
+    mu_assert("test_grep_format failed", line->nbhighlight == 1);
+    mu_assert("test_grep_format failed", get_highlights(line)[0].begin == 4 &&
+                                                 get_highlights(line)[0].end == 8);
+    mu_assert("test_grep_format failed",
+              strcmp(line->entry.data, "int main()") == 0);
+    free_result(result);
+
+    return 0;
+}
+
+static char *test_filter_view() {
+    struct result_t *result = create_result();
+    const struct format_t *format = get_format("vimgrep");
+    struct view_t *view, *narrowed;
+    char record[64];
+    int headers = 0, file = -1;
+    int i;
+
+    result->max_line_length = DEFAULT_MAX_LINE_LENGTH;
+    for (i = 0; i < 10000; i++) {
+        snprintf(record, sizeof(record), "dir%d/f.c:%d:1:%s", i / 100, i + 1,
+                 i % 3 == 0 ? "a needle" : "hay");
+        format->parse_line(result, record, strlen(record));
+    }
+
+    /* ranges filtered by different threads share files */
+    view = create_view(result, "NEEDLE", NULL, 4);
+    mu_assert("test_filter_view failed", view->nbselectable == 3334);
+    mu_assert("test_filter_view failed", view->nbentry == 3434);
+    for (i = 0; i < view->nbentry; i++) {
+        struct entry_t *entry = get_view_entry(view, i);
+        struct line_t *line = get_type(entry, LINE_ENTRY);
+
+        if (entry->type == FILE_ENTRY) headers++;
+        if (line && line->file != file) {
+            file = line->file;
+            mu_assert("test_filter_view failed",
+                      get_view_entry(view, i - 1)->type == FILE_ENTRY);
+        }
+    }
+    mu_assert("test_filter_view failed", headers == 100);
+    mu_assert("test_filter_view failed", next_view_selectable(view, 0) == 1);
+    mu_assert("test_filter_view failed",
+              previous_view_selectable(view, 1) == 1);
+
+    narrowed = create_view(result, "NEEDLE", view, 4);
+    mu_assert("test_filter_view failed", narrowed->nbentry == 3434);
+    free_view(narrowed);
+
+    /* path fragments keep every line of their files */
+    narrowed = create_view(result, "dir7/", view, 4);
+    mu_assert("test_filter_view failed", narrowed->nbentry == 101);
+    free_view(narrowed);
+
+    /* results added later */
+    snprintf(record, sizeof(record), "dir99/f.c:10001:1:needle");
+    format->parse_line(result, record, strlen(record));
+    snprintf(record, sizeof(record), "last.c:1:1:needle");
+    format->parse_line(result, record, strlen(record));
+    update_view(view, result);
+    mu_assert("test_filter_view failed", view->nbentry == 3437);
+
+    free_view(view);
+    free_result(result);
+
+    return 0;
+}
+
+static char *test_group_view() {
+    struct result_t *result = create_result();
+    const struct format_t *format = get_format("vimgrep");
+    struct view_t *view, *narrowed;
+    struct batch_t *batch;
+    struct group_t *group;
+    range_t match = {0, 1};
+    char record[64];
+    int i, file;
+
+    result->max_line_length = DEFAULT_MAX_LINE_LENGTH;
+    for (i = 0; i < 10000; i++) {
+        snprintf(record, sizeof(record), "dir%d/f.c:%d:1:needle", i / 100,
+                 i + 1);
+        format->parse_line(result, record, strlen(record));
+    }
+
+    /* one row per file, folded */
+    view = create_group_view(result, "", NULL);
+    mu_assert("test_group_view failed", view->nbentry == 100);
+    mu_assert("test_group_view failed", get_file(result, 7)->count == 100);
+    mu_assert("test_group_view failed", has_file_lines(result, 7));
+
+    mu_assert("test_group_view failed",
+              toggle_view_group(view, result, 7) == 7);
+    mu_assert("test_group_view failed", view->nbentry == 200);
+    mu_assert("test_group_view failed",
+              get_view_group(view, 50, &file) && file == 7);
+    mu_assert("test_group_view failed", next_view_file(view, 8) == 108);
+
+    /* lines of the last file expanded keep coming */
+    mu_assert("test_group_view failed",
+              toggle_view_group(view, result, 99) == 199);
+    snprintf(record, sizeof(record), "dir99/f.c:10001:1:needle");
+    format->parse_line(result, record, strlen(record));
+    snprintf(record, sizeof(record), "last.c:1:1:needle");
+    format->parse_line(result, record, strlen(record));
+    update_view(view, result);
+    mu_assert("test_group_view failed", view->nbentry == 302);
+
+    /* the matches of a files only search are counted, then read */
+    batch = create_batch("counted.c", 0);
+    batch->count_only = 1;
+    for (i = 0; i < 3; i++) add_batch_line(batch, "needle", 6, i + 1, match);
+    commit_batch(result, batch);
+    free_batch(batch);
+    mu_assert("test_group_view failed", get_file(result, 101)->count == 3);
+    mu_assert("test_group_view failed", !has_file_lines(result, 101));
+
+    update_view(view, result);
+    group = get_view_group(view, view->nbentry - 1, &file);
+    mu_assert("test_group_view failed", group && file == 101);
+    batch = create_batch("counted.c", 0);
+    for (i = 0; i < 3; i++) add_batch_line(batch, "needle", 6, i + 1, match);
+    group->lines = malloc(batch->nbline * sizeof(*group->lines));
+    group->nbline = detach_batch(result, batch, file, group->lines);
+    free_batch(batch);
+    toggle_view_group(view, result, file);
+    mu_assert("test_group_view failed", view->nbentry == 306);
+    mu_assert("test_group_view failed",
+              get_type(get_view_entry(view, 305), LINE_ENTRY) != NULL);
+    mu_assert("test_group_view failed", result->nbselectable == 10002);
+
+    /* a filter keeps the files whose path contains it, expanded or not */
+    narrowed = create_group_view(result, "dir7/", view);
+    mu_assert("test_group_view failed", narrowed->nbentry == 101);
+    free_view(narrowed);
+
+    free_view(view);
+    free_result(result);
+
+    return 0;
+}
+
+static char *test_preview() {
+    char directory[] = "/tmp/ngp-test-XXXXXX";
+    char path[PATH_MAX];
+    char command[PATH_MAX * 2];
+    struct preview_t *preview = create_preview();
+    struct mapped_file_t *file;
+    const char *line;
+    size_t length;
+    int i;
+
+    mu_assert("test_preview failed", mkdtemp(directory) != NULL);
+    snprintf(path, sizeof(path), "%s/first.c", directory);
+    write_fake_file(path, "first\n\nthird without end of line");
+
+    file = get_mapped_file(preview, path);
+    mu_assert("test_preview failed", file && file->nbline == 3);
+    line = get_mapped_line(file, 1, &length);
+    mu_assert("test_preview failed", length == 5 && !strncmp(line, "first", 5));
+    line = get_mapped_line(file, 2, &length);
+    mu_assert("test_preview failed", line && length == 0);
+    line = get_mapped_line(file, 3, &length);
+    mu_assert("test_preview failed", length == 25);
+    mu_assert("test_preview failed", !get_mapped_line(file, 4, &length));
+    mu_assert("test_preview failed", get_mapped_file(preview, path) == file);
+
+    /* the least recently used file goes first */
+    for (i = 0; i < PREVIEW_FILES; i++) {
+        snprintf(path, sizeof(path), "%s/%d.c", directory, i);
+        write_fake_file(path, "line\n");
+        mu_assert("test_preview failed", get_mapped_file(preview, path));
+    }
+    mu_assert("test_preview failed", preview->nbfile == PREVIEW_FILES);
+    for (i = 0; i < preview->nbfile; i++)
+        mu_assert("test_preview failed",
+                  !strstr(preview->files[i].path, "first.c"));
+
+    snprintf(path, sizeof(path), "%s/missing.c", directory);
+    mu_assert("test_preview failed", !get_mapped_file(preview, path));
+
+    snprintf(command, sizeof(command), "rm -rf %s", directory);
+    mu_assert("test_preview failed", system(command) == 0);
+    free_preview(preview);
+
+    return 0;
+}
+
 static char *test_get_file_name_simple() {
     char file_name[FILENAME_MAX];
     char *result = get_file_name("/file1", file_name);
@@ -521,6 +1469,8 @@ static char *all_tests() {
     mu_run_test(test_two_entries);
     mu_run_test(test_regexp_start_of_line);
     mu_run_test(test_wrong_regexp);
+    mu_run_test(test_long_line_is_cropped);
+    mu_run_test(test_highlights_are_aligned);
     mu_run_test(test_is_specific_file_ok);
     mu_run_test(test_is_specific_file_ko);
     mu_run_test(test_is_ignored_file_ok);
@@ -530,12 +1480,34 @@ static char *all_tests() {
     mu_run_test(test_cursor_down);
     mu_run_test(test_cursor_down_end_of_entries);
     mu_run_test(test_cursor_down_skip_file);
+    mu_run_test(test_next_and_previous_file);
     mu_run_test(test_cursor_down_end_of_page);
     mu_run_test(test_cursor_down_end_of_page_skip_file);
     mu_run_test(test_cursor_up);
     mu_run_test(test_cursor_up_top_first_page);
     mu_run_test(test_cursor_up_skip_file);
     mu_run_test(test_cursor_up_page_up);
+    mu_run_test(test_selectable_index);
+    mu_run_test(test_get_entry);
+    mu_run_test(test_line_owning_file);
+    mu_run_test(test_spill_results);
+    mu_run_test(test_sorted_search);
+    mu_run_test(test_search_restart);
+    mu_run_test(test_scan_file);
+    mu_run_test(test_search_error);
+    mu_run_test(test_hybrid_search);
+    mu_run_test(test_history);
+    mu_run_test(test_auto_search);
+    mu_run_test(test_notify_search);
+    mu_run_test(test_filter_view);
+    mu_run_test(test_group_view);
+    mu_run_test(test_preview);
+    mu_run_test(test_intern_path);
+    mu_run_test(test_tokenize_ansi);
+    mu_run_test(test_parse_json);
+    mu_run_test(test_null_format);
+    mu_run_test(test_json_format);
+    mu_run_test(test_grep_format);
     mu_run_test(test_get_file_name_simple);
     mu_run_test(test_get_file_name_multiple);
     mu_run_test(test_get_file_name_current_dir);